@@ -29,28 +29,149 @@
 // Rekonq Includes
 #include "rekonq_defines.h"
 
+// Qt Includes
+#include <QStringList>
+
+
+// Options not changing the requests matched by an host filter
+static inline bool isHostNeutralOption(const QString &option)
+{
+    return option == QL1S("match-case")
+           || option == QL1S("collapse")
+           || option == QL1S("~collapse");
+}
+
+
+AdBlockHostMatcher::AdBlockHostMatcher()
+    : m_nodes(1)
+{
+}
+
+
 bool AdBlockHostMatcher::tryAddFilter(const QString &filter)
 {
-    if (filter.startsWith(QL1S("||")))
+    if (!filter.startsWith(QL1S("||")))
+        return false;
+
+    QString domain = filter.mid(2);
+
+    const int optionsNumber = domain.lastIndexOf(QL1C('$'));
+    if (optionsNumber >= 0)
     {
+        const QStringList options = domain.mid(optionsNumber + 1).split(QL1C(','));
+        Q_FOREACH(const QString & option, options)
+        {
+            if (!isHostNeutralOption(option))
+                return false;
+        }
+        domain = domain.left(optionsNumber);
+    }
 
-        QString domain = filter.mid(2);
+    // "^|" is the same as "^" here: the separator is the host end
+    if (domain.endsWith(QL1S("^|")))
+        domain.chop(1);
 
-        if (!domain.endsWith(QL1C('^')))
-            return false;
+    if (!domain.endsWith(QL1C('^')))
+        return false;
+
+    domain.chop(1);
+
+    if (domain.isEmpty())
+        return false;
+
+    if (domain.contains(QL1C('/'))
+            || domain.contains(QL1C('*'))
+            || domain.contains(QL1C('^'))
+            || domain.contains(QL1C('|'))
+            || domain.contains(QL1C(':')))
+        return false;
+
+    domain = domain.toLower();
+    const int filter = m_domains.count();
+    m_domains << domain;
+    m_hits << 0;
+
+    addDomain(domain, filter);
+    return true;
+}
 
-        if (domain.contains(QL1C('$')))
-            return false;
 
-        domain = domain.left(domain.size() - 1);
+bool AdBlockHostMatcher::match(const QString &host) const
+{
+    // just the root...
+    if (m_nodes.count() == 1)
+        return false;
+
+    // "ads.example.com." is the same (fully qualified) host as "ads.example.com"
+    int labelEnd = host.length();
+    if (host.endsWith(QL1C('.')))
+        labelEnd--;
+
+    int node = 0;
+    while (labelEnd > 0)
+    {
+        const int dot = host.lastIndexOf(QL1C('.'), labelEnd - 1);
+        const QString label = host.mid(dot + 1, labelEnd - dot - 1);
 
-        if (domain.contains(QL1C('/')) || domain.contains(QL1C('*')) || domain.contains(QL1C('^')))
+        const QHash<QString, int> &children = m_nodes.at(node).children;
+        QHash<QString, int>::const_iterator it = children.constFind(label);
+        if (it == children.constEnd())
             return false;
 
-        domain = domain.toLower();
-        m_hostList.insert(domain);
-        m_hostList.insert(QL1S("www.") + domain);
-        return true;
+        node = it.value();
+        const int filter = m_nodes.at(node).filter;
+        if (filter >= 0)
+        {
+            m_hits[filter]++;
+            return true;
+        }
+
+        labelEnd = dot;
     }
+
     return false;
 }
+
+
+void AdBlockHostMatcher::clear()
+{
+    m_nodes.clear();
+    m_nodes.resize(1);
+    m_domains.clear();
+    m_hits.clear();
+}
+
+
+void AdBlockHostMatcher::addDomain(const QString &domain, int filter)
+{
+    int node = 0;
+    int labelEnd = domain.length();
+    while (labelEnd > 0)
+    {
+        // a parent domain is already listed: nothing to do
+        if (m_nodes.at(node).filter >= 0)
+            return;
+
+        const int dot = domain.lastIndexOf(QL1C('.'), labelEnd - 1);
+        const QString label = domain.mid(dot + 1, labelEnd - dot - 1);
+
+        int child = m_nodes.at(node).children.value(label, -1);
+        if (child < 0)
+        {
+            child = m_nodes.count();
+            m_nodes.append(Node());
+            m_nodes[node].children.insert(label, child);
+        }
+
+        node = child;
+        labelEnd = dot;
+    }
+
+    // already listed: the first filter wins
+    if (m_nodes.at(node).filter >= 0)
+        return;
+
+    // subdomains are matched by this node now, no need to remember them
+    m_nodes[node].filter = filter;
+    m_nodes[node].children.clear();
+}
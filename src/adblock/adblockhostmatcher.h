@@ -26,29 +26,65 @@
 #ifndef ADBLOCKHOSTMATCHER_H
 #define ADBLOCKHOSTMATCHER_H
 
-#include <QSet>
+#include <QHash>
 #include <QString>
+#include <QStringList>
+#include <QVector>
 
+
+// Hosts are stored in a trie keyed on their reversed domain labels
+// (eg: ads.example.com is stored as com -> example -> ads), so that
+// one walk tells if an host OR one of its parent domains is listed.
+// As a nice side effect, there is no need to store "www." hosts.
 class AdBlockHostMatcher
 {
 public:
+    AdBlockHostMatcher();
+
     // Try to add an adblock filter to this host matcher.
     // If the filter is not an hostname, the filter is not added
     // and the method return false;
     bool tryAddFilter(const QString &filter);
 
-    bool match(const QString &host) const
+    // NOTE: host is expected lowercase, as QUrl::host() returns it
+    bool match(const QString &host) const;
+
+    // number of filters added
+    int count() const
+    {
+        return m_domains.count();
+    }
+
+    // The domain of a filter, and how many times it matched. A filter never matching
+    // can be shadowed by a parent domain one (eg: ads.example.com by example.com)
+    const QString &domain(int filter) const
     {
-        return m_hostList.contains(host.toLower());
+        return m_domains.at(filter);
     }
 
-    void clear()
+    int hits(int filter) const
     {
-        m_hostList.clear();
+        return m_hits.at(filter);
     }
 
+    void clear();
+
 private:
-    QSet<QString> m_hostList;
+    void addDomain(const QString &domain, int filter);
+
+    struct Node
+    {
+        Node() : filter(-1) {}
+
+        QHash<QString, int> children;
+        int filter;     // the filter listing the domain ending here, or -1
+    };
+
+    QVector<Node> m_nodes;
+    QStringList m_domains;
+
+    // NOTE: counted on match, so a matcher is not meant to be shared between threads
+    mutable QVector<int> m_hits;
 };
 
 #endif // ADBLOCKHOSTMATCHER_H
@@ -33,36 +33,70 @@
 
 // Local Includes
 #include "adblocknetworkreply.h"
+#include "adblockoptions.h"
+#include "adblockrulecache.h"
 #include "adblockwidget.h"
 #include "blockedelementswidget.h"
 
+#include "application.h"
+#include "mainwindow.h"
 #include "webpage.h"
+#include "webtab.h"
 
 // KDE Includes
-#include <KIO/FileCopyJob>
+#include <KSaveFile>
 #include <KStandardDirs>
 
 // Qt Includes
+#include <QtConcurrentRun>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
 #include <QUrl>
 #include <QWebElement>
+#include <QWebFrame>
 #include <QNetworkReply>
 #include <QNetworkRequest>
+#include <QRegExp>
+
+
+// Schemes of the requests rules are about. NOTE: QtWebKit opens web sockets by itself,
+// so ws and wss requests reach us just when a plugin or a script asks them to the network manager
+static inline bool isBlockableScheme(const QString &scheme)
+{
+    return scheme == QL1S("http")
+           || scheme == QL1S("https")
+           || scheme == QL1S("ws")
+           || scheme == QL1S("wss");
+}
 
 
 AdBlockManager::AdBlockManager(QObject *parent)
     : QObject(parent)
     , _isAdblockEnabled(false)
     , _isHideAdsEnabled(false)
+    , _ruleSetNeedsReload(false)
+    , _reloadPageOnRuleSetLoaded(false)
+    , _decisionCache(2048)
+    , _decisionCacheHits(0)
+    , _decisionCacheMisses(0)
 {
+    connect(&_ruleSetWatcher, SIGNAL(finished()), this, SLOT(ruleSetLoaded()));
+
     loadSettings();
 }
 
 
 AdBlockManager::~AdBlockManager()
 {
-    _whiteList.clear();
-    _blackList.clear();
-    _hideList.clear();
+    // do not leak a rule set still loading
+    if (_ruleSetWatcher.isRunning())
+    {
+        _ruleSetWatcher.disconnect(this);
+        _ruleSetWatcher.waitForFinished();
+        delete _ruleSetWatcher.result();
+    }
 }
 
 
@@ -96,35 +130,24 @@ void AdBlockManager::loadSettings()
     _adblockConfig = KSharedConfig::openConfig("adblockrc", KConfig::SimpleConfig, "appdata");
     // ----------------
 
-    _hostWhiteList.clear();
-    _hostBlackList.clear();
-
-    _whiteList.clear();
-    _blackList.clear();
-    _hideList.clear();
+    _rulesFiles.clear();
 
     KConfigGroup settingsGroup(_adblockConfig, "Settings");
     _isAdblockEnabled = settingsGroup.readEntry("adBlockEnabled", false);
 
     // no need to load filters if adblock is not enabled :)
     if (!_isAdblockEnabled)
+    {
+        _ruleSet.clear();
+        clearDecisionCache();
         return;
+    }
 
     // just to be sure..
     _isHideAdsEnabled = settingsGroup.readEntry("hideAdsEnabled", false);
 
     // ----------------------------------------------------------
 
-    QDateTime today = QDateTime::currentDateTime();
-    QDateTime lastUpdate = QDateTime::fromString(settingsGroup.readEntry("lastUpdate", QString()));
-    int days = settingsGroup.readEntry("updateInterval", 7);
-
-    bool allSubscriptionsNeedUpdate = (today > lastUpdate.addDays(days));
-    if (allSubscriptionsNeedUpdate)
-    {
-        settingsGroup.writeEntry("lastUpdate", today.toString());
-    }
-
     // (Eventually) update and load automatic rules
     KConfigGroup filtersGroup(_adblockConfig, "FiltersList");
     for (int i = 0; i < 60; i++)
@@ -137,86 +160,63 @@ void AdBlockManager::loadSettings()
         if (!isFilterEnabled)
             continue;
 
-        bool fileExists = subscriptionFileExists(i);
-        if (allSubscriptionsNeedUpdate || !fileExists)
+        if (!subscriptionFileExists(i) || subscriptionNeedsUpdate(i))
         {
-            kDebug() << "FILE SHOULDN'T EXIST. updating subscription";
+            kDebug() << "Updating subscription" << n;
             updateSubscription(i);
         }
-        else
-        {
-            QString rulesFilePath = KStandardDirs::locateLocal("appdata" , QL1S("adblockrules_") + n);
-            loadRules(rulesFilePath);
-        }
+
+        // NOTE: (old) rules of a subscription being updated are loaded anyway,
+        // until the new ones are ready
+        QString rulesFilePath = KStandardDirs::locateLocal("appdata" , QL1S("adblockrules_") + n);
+        _rulesFiles << rulesFilePath;
     }
 
     // load local rules
     QString localRulesFilePath = KStandardDirs::locateLocal("appdata" , QL1S("adblockrules_local"));
-    loadRules(localRulesFilePath);
+    _rulesFiles << localRulesFilePath;
+
+    loadRuleSet();
 }
 
 
-void AdBlockManager::loadRules(const QString &rulesFilePath)
+void AdBlockManager::loadRuleSet()
 {
-    QFile ruleFile(rulesFilePath);
-    if (!ruleFile.open(QFile::ReadOnly | QFile::Text))
+    // just one load at a time: the running one will be restarted when finished
+    if (_ruleSetWatcher.isRunning())
     {
-        kDebug() << "Unable to open rule file" << rulesFilePath;
+        _ruleSetNeedsReload = true;
         return;
     }
+    _ruleSetNeedsReload = false;
 
-    QTextStream in(&ruleFile);
-    while (!in.atEnd())
-    {
-        QString stringRule = in.readLine();
-        loadRuleString(stringRule);
-    }
+    const QString cacheDir = KStandardDirs::locateLocal("cache", QL1S("adblock/"), true);
+    _ruleSetWatcher.setFuture(QtConcurrent::run(AdBlockRuleSet::loadFiles, _rulesFiles, cacheDir));
 }
 
 
-void AdBlockManager::loadRuleString(const QString &stringRule)
+void AdBlockManager::ruleSetLoaded()
 {
-    // ! rules are comments
-    if (stringRule.startsWith('!'))
-        return;
+    AdBlockRuleSet *ruleSet = _ruleSetWatcher.result();
 
-    // [ rules are ABP info
-    if (stringRule.startsWith('['))
-        return;
-
-    // empty rules are just dangerous..
-    // (an empty rule in whitelist allows all, in blacklist blocks all..)
-    if (stringRule.isEmpty())
-        return;
-
-    // white rules
-    if (stringRule.startsWith(QL1S("@@")))
+    // rules changed while loading: this set is already old
+    if (_ruleSetNeedsReload || !_isAdblockEnabled)
     {
-        const QString filter = stringRule.mid(2);
-        if (_hostWhiteList.tryAddFilter(filter))
-            return;
-
-        AdBlockRule rule(filter);
-        _whiteList << rule;
+        delete ruleSet;
+        if (_isAdblockEnabled)
+            loadRuleSet();
         return;
     }
 
-    // hide (CSS) rules
-    if (stringRule.startsWith(QL1S("##")))
+    // swap in the new set: requests will use it from now on
+    _ruleSet = QSharedPointer<AdBlockRuleSet>(ruleSet);
+    clearDecisionCache();
+
+    if (_reloadPageOnRuleSetLoaded)
     {
-        _hideList << stringRule.mid(2);
-        return;
+        _reloadPageOnRuleSetLoaded = false;
+        emit reloadCurrentPage();
     }
-
-    // TODO implement domain-specific hiding
-    if (stringRule.contains(QL1S("##")))
-        return;
-
-    if (_hostBlackList.tryAddFilter(stringRule))
-        return;
-
-    AdBlockRule rule(stringRule);
-    _blackList << rule;
 }
 
 
@@ -225,8 +225,12 @@ QNetworkReply *AdBlockManager::block(const QNetworkRequest &request, WebPage *pa
     if (!_isAdblockEnabled)
         return 0;
 
-    // we (ad)block just http traffic
-    if (request.url().scheme() != QL1S("http"))
+    // rules are not loaded yet...
+    if (!_ruleSet)
+        return 0;
+
+    // we (ad)block just web traffic
+    if (!isBlockableScheme(request.url().scheme()))
         return 0;
 
     QString urlString = request.url().toString();
@@ -235,70 +239,107 @@ QNetworkReply *AdBlockManager::block(const QNetworkRequest &request, WebPage *pa
     const QString urlStringLowerCase = urlString.toLower();
     const QString host = request.url().host();
 
-    // check white rules before :)
-    if (_hostWhiteList.match(host))
-    {
-        kDebug() << "ADBLOCK: WHITE RULE (@@) Matched by string: " << urlString;
-        return 0;
-    }
+    // request type and (third) party, to skip rules not about this request
+    const quint16 requestOptions = AdBlockOptions::requestOptions(request);
 
-    Q_FOREACH(const AdBlockRule & filter, _whiteList)
+    // Decisions are cached by url, first party host and request options: the same
+    // ads (and trackers) are requested again and again, by frames, reloads and tabs
+    const QWebFrame *frame = qobject_cast<QWebFrame *>(request.originatingObject());
+    const QString firstPartyHost = frame ? frame->url().host() : QString();
+    const QString decisionKey = urlString + QL1C(' ') + firstPartyHost + QL1C(' ') + QString::number(requestOptions);
+
+    AdBlockPageStatistics *pageStatistics = page ? &page->adBlockStatistics() : 0;
+    if (pageStatistics)
+        pageStatistics->checkedRequests++;
+
+    AdBlockRuleSet::Decision decision;
+    AdBlockRuleSet::Decision *cachedDecision = _decisionCache.object(decisionKey);
+    if (cachedDecision)
     {
-        if (filter.match(request, urlString, urlStringLowerCase))
-        {
-            kDebug() << "ADBLOCK: WHITE RULE (@@) Matched by string: " << urlString;
-            return 0;
-        }
-    }
+        _decisionCacheHits++;
+        decision = *cachedDecision;
 
-    // then check the black ones :(
-    if (_hostBlackList.match(host))
+        if (pageStatistics)
+            pageStatistics->cachedDecisions++;
+    }
+    else
     {
-        kDebug() << "ADBLOCK: BLACK RULE Matched by string: " << urlString;
-        AdBlockNetworkReply *reply = new AdBlockNetworkReply(request, urlString, this);
-        _blockedElements << request.url().toString();
-        page->setHasAdBlockedElements(true);
-        return reply;
+        _decisionCacheMisses++;
+
+        QElapsedTimer timer;
+        timer.start();
+        decision = _ruleSet->decision(request, urlString, urlStringLowerCase, host, requestOptions);
+        _decisionCache.insert(decisionKey, new AdBlockRuleSet::Decision(decision));
+
+        if (pageStatistics)
+            pageStatistics->matchTime += timer.nsecsElapsed();
     }
 
-    // get sure page is extant to perform elements check. bug:282012
+    if (decision == AdBlockRuleSet::NotBlocked)
+        return 0;
+
+    kDebug() << "ADBLOCK: BLACK RULE Matched by string: " << urlString;
+
+    AdBlockNetworkReply *reply = new AdBlockNetworkReply(request, urlString, this);
+    _blockedElements << request.url().toString();
+
+    // requests with no page are blocked too: there is just nothing to collapse. bug:282012
     if (!page)
+        return reply;
+
+    pageStatistics->blockedRequests++;
+
+    // elements loading it are collapsed later, all together
+    page->collapseBlockedElements(request.url());
+
+    page->setHasAdBlockedElements(true);
+    return reply;
+}
+
+
+void AdBlockManager::clearDecisionCache()
+{
+    kDebug() << "ADBLOCK: decision cache hits:" << _decisionCacheHits << "misses:" << _decisionCacheMisses;
+    _decisionCache.clear();
+}
+
+
+int AdBlockManager::decisionCacheHits() const
+{
+    return _decisionCacheHits;
+}
+
+
+int AdBlockManager::decisionCacheMisses() const
+{
+    return _decisionCacheMisses;
+}
+
+
+QList<AdBlockRuleStatistics> AdBlockManager::ruleStatistics() const
+{
+    if (!_ruleSet)
+        return QList<AdBlockRuleStatistics>();
+
+    return _ruleSet->ruleStatistics();
+}
+
+
+qint64 AdBlockManager::matchTime(AdBlockRuleStatistics::RuleClass ruleClass) const
+{
+    if (!_ruleSet)
         return 0;
 
-    Q_FOREACH(const AdBlockRule & filter, _blackList)
-    {
-        if (filter.match(request, urlString, urlStringLowerCase))
-        {
-            kDebug() << "ADBLOCK: BLACK RULE Matched by string: " << urlString;
-
-            QWebElement document = page->mainFrame()->documentElement();
-            QWebElementCollection elements = document.findAll("*");
-            Q_FOREACH(QWebElement el, elements)
-            {
-                QString srcAttribute = el.attribute("src");
-                if (srcAttribute.isEmpty())
-                    continue;
-
-                if (!srcAttribute.startsWith(QL1S("http")))
-                    srcAttribute = host + srcAttribute;
-
-                if (filter.match(request, srcAttribute, srcAttribute.toLower()))
-                {
-                    el.setStyleProperty(QL1S("visibility"), QL1S("hidden"));
-                    el.setStyleProperty(QL1S("width"), QL1S("0"));
-                    el.setStyleProperty(QL1S("height"), QL1S("0"));
-                }
-            }
-
-            AdBlockNetworkReply *reply = new AdBlockNetworkReply(request, urlString, this);
-            _blockedElements << request.url().toString();
-            page->setHasAdBlockedElements(true);
-            return reply;
-        }
-    }
+    return _ruleSet->matchTime(ruleClass);
+}
 
-    // no match
-    return 0;
+
+AdBlockPageStatistics AdBlockManager::pageStatistics(WebPage *page) const
+{
+    if (!page)
+        return AdBlockPageStatistics();
+
+    return page->adBlockStatistics();
 }
 
 
@@ -313,24 +354,69 @@ void AdBlockManager::applyHidingRules(WebPage *page)
     if (!_isHideAdsEnabled)
         return;
 
-    QWebElement document = page->mainFrame()->documentElement();
+    if (!_ruleSet)
+        return;
 
-    // HIDE RULES
-    Q_FOREACH(const QString & filter, _hideList)
+    applyHidingRules(page->mainFrame(), page);
+}
+
+
+void AdBlockManager::applyHidingRules(QWebFrame *frame, WebPage *page)
+{
+    Q_FOREACH(QWebFrame * childFrame, frame->childFrames())
     {
-        QWebElementCollection elements = document.findAll(filter);
+        applyHidingRules(childFrame, page);
+    }
 
-        Q_FOREACH(QWebElement el, elements)
-        {
-            if (el.isNull())
-                continue;
-            kDebug() << "Hide element: " << el.localName();
-            el.setStyleProperty(QL1S("visibility"), QL1S("hidden"));
-            el.removeFromDocument();
-            _hidedElements++;
-            page->setHasAdBlockedElements(true);
-        }
+    // already done (eg: loadFinished emitted again)
+    if (!frame->findFirstElement(QL1S("style#rekonq-adblock-hiding")).isNull())
+        return;
+
+    QWebElement head = frame->findFirstElement(QL1S("head"));
+    if (head.isNull())
+        head = frame->documentElement();
+    if (head.isNull())
+        return;
+
+    // Just one stylesheet (the generic rules are compiled once, in the rule set):
+    // let WebKit style engine find the elements to hide
+    const QString host = frame->url().host().toLower();
+    QString styleSheet = _ruleSet->hideStyleSheet(host);
+
+    const QStringList domainRules = _ruleSet->domainHideRules(host);
+    if (!domainRules.isEmpty())
+    {
+        styleSheet += AdBlockRuleSet::buildHideStyleSheet(domainRules);
+        page->setHasAdBlockedElements(true);
+    }
+
+    if (styleSheet.isEmpty())
+        return;
+
+    head.appendInside(QL1S("<style id=\"rekonq-adblock-hiding\" type=\"text/css\">")
+                      + styleSheet
+                      + QL1S("</style>"));
+}
+
+
+int AdBlockManager::hiddenElementsCount(QWebFrame *frame) const
+{
+    int count = 0;
+    Q_FOREACH(QWebFrame * childFrame, frame->childFrames())
+    {
+        count += hiddenElementsCount(childFrame);
+    }
+
+    const QString host = frame->url().host().toLower();
+    QStringList selectors = _ruleSet->hideRules(host);
+    selectors << _ruleSet->domainHideRules(host);
+
+    QWebElement document = frame->documentElement();
+    Q_FOREACH(const QString & selector, selectors)
+    {
+        count += document.findAll(selector).count();
     }
+    return count;
 }
 
 
@@ -342,16 +428,32 @@ void AdBlockManager::updateSubscription(int i)
     QString fUrl = filtersGroup.readEntry("FilterURL-" + n, QString());
     KUrl subUrl = KUrl(fUrl);
 
-    QString rulesFilePath = KStandardDirs::locateLocal("appdata" , QL1S("adblockrules_") + n);
-    KUrl destUrl = KUrl(rulesFilePath);
+    KIO::StoredTransferJob* job = KIO::storedGet(subUrl, KIO::Reload, KIO::HideProgressInfo);
+    job->addMetaData("ssl_no_client_cert", "TRUE");
+    job->addMetaData("ssl_no_ui", "TRUE");
+    job->addMetaData("UseCache", "false");
+    job->addMetaData("cookies", "none");
+    job->addMetaData("no-auth", "true");
+    job->addMetaData("PropagateHttpHeader", "true");
+
+    // Ask for the list just if it changed since last download
+    if (subscriptionFileExists(i))
+    {
+        QStringList conditionalHeaders;
 
-    KIO::FileCopyJob* job = KIO::file_copy(subUrl , destUrl, -1, KIO::HideProgressInfo);
-    job->metaData().insert("ssl_no_client_cert", "TRUE");
-    job->metaData().insert("ssl_no_ui", "TRUE");
-    job->metaData().insert("UseCache", "false");
-    job->metaData().insert("cookies", "none");
-    job->metaData().insert("no-auth", "true");
+        const QString eTag = filtersGroup.readEntry("FilterETag-" + n, QString());
+        if (!eTag.isEmpty())
+            conditionalHeaders << QL1S("If-None-Match: ") + eTag;
 
+        const QString lastModified = filtersGroup.readEntry("FilterLastModified-" + n, QString());
+        if (!lastModified.isEmpty())
+            conditionalHeaders << QL1S("If-Modified-Since: ") + lastModified;
+
+        if (!conditionalHeaders.isEmpty())
+            job->addMetaData("customHTTPHeader", conditionalHeaders.join(QL1S("\r\n")));
+    }
+
+    job->setProperty("subscription", i);
     connect(job, SIGNAL(finished(KJob *)), this, SLOT(slotFinished(KJob *)));
 }
 
@@ -361,10 +463,70 @@ void AdBlockManager::slotFinished(KJob *job)
     if (job->error())
         return;
 
-    KIO::FileCopyJob *fJob = qobject_cast<KIO::FileCopyJob *>(job);
-    KUrl url = fJob->destUrl();
-    url.setProtocol(QString()); // this is needed to load local url well :(
-    loadRules(url.url());
+    KIO::StoredTransferJob *transferJob = qobject_cast<KIO::StoredTransferJob *>(job);
+    if (!transferJob)
+        return;
+
+    const int i = job->property("subscription").toInt();
+    const QString n = QString::number(i + 1);
+
+    KConfigGroup filtersGroup(_adblockConfig, "FiltersList");
+    filtersGroup.writeEntry("FilterLastUpdate-" + n, QDateTime::currentDateTime());
+
+    // not modified: old rules (and their cache) are still good
+    if (transferJob->queryMetaData(QL1S("responsecode")) == QL1S("304"))
+    {
+        kDebug() << "Subscription" << n << "not modified";
+        return;
+    }
+
+    const QByteArray rules = transferJob->data();
+    if (rules.isEmpty())
+        return;
+
+    // save validators for the next conditional update
+    QString eTag;
+    QString lastModified;
+    const QStringList headers = transferJob->queryMetaData(QL1S("HTTP-Headers")).split(QL1C('\n'));
+    Q_FOREACH(const QString & header, headers)
+    {
+        const int colon = header.indexOf(QL1C(':'));
+        if (colon < 0)
+            continue;
+
+        const QString name = header.left(colon).trimmed().toLower();
+        if (name == QL1S("etag"))
+            eTag = header.mid(colon + 1).trimmed();
+        else if (name == QL1S("last-modified"))
+            lastModified = header.mid(colon + 1).trimmed();
+    }
+    filtersGroup.writeEntry("FilterETag-" + n, eTag);
+    filtersGroup.writeEntry("FilterLastModified-" + n, lastModified);
+    filtersGroup.writeEntry("FilterExpires-" + n, subscriptionExpiresHours(rules));
+
+    // Servers not supporting conditional requests can send the same list again:
+    // leave the file (and so its rules cache) untouched, then
+    const QString rulesFilePath = KStandardDirs::locateLocal("appdata" , QL1S("adblockrules_") + n);
+    {
+        QFile oldRulesFile(rulesFilePath);
+        if (oldRulesFile.open(QFile::ReadOnly) && oldRulesFile.readAll() == rules)
+        {
+            kDebug() << "Subscription" << n << "not changed";
+            return;
+        }
+    }
+
+    KSaveFile rulesFile(rulesFilePath);
+    if (!rulesFile.open() || rulesFile.write(rules) != rules.size() || !rulesFile.finalize())
+    {
+        kDebug() << "Unable to save rule file" << rulesFilePath;
+        rulesFile.abort();
+        return;
+    }
+
+    // new rules file is there: rebuild the rule set. The other files come from their
+    // caches, while the old rules of this one are just replaced by the new ones
+    loadRuleSet();
 }
 
 
@@ -377,6 +539,56 @@ bool AdBlockManager::subscriptionFileExists(int i)
 }
 
 
+bool AdBlockManager::subscriptionNeedsUpdate(int i)
+{
+    KConfigGroup settingsGroup(_adblockConfig, "Settings");
+    KConfigGroup filtersGroup(_adblockConfig, "FiltersList");
+    QString n = QString::number(i + 1);
+
+    // lists downloaded before per list update times were updated all together
+    const QDateTime lastUpdate = filtersGroup.readEntry("FilterLastUpdate-" + n,
+                                 QDateTime::fromString(settingsGroup.readEntry("lastUpdate", QString())));
+    if (!lastUpdate.isValid())
+        return true;
+
+    // lists can tell how often they should be updated, through the "! Expires:" header
+    QDateTime expires;
+    const int expiresHours = filtersGroup.readEntry("FilterExpires-" + n, 0);
+    if (expiresHours > 0)
+        expires = lastUpdate.addSecs(expiresHours * 3600);
+    else
+        expires = lastUpdate.addDays(settingsGroup.readEntry("updateInterval", 7));
+
+    return QDateTime::currentDateTime() > expires;
+}
+
+
+int AdBlockManager::subscriptionExpiresHours(const QByteArray &rules)
+{
+    // eg: "! Expires: 4 days (update frequency)", in the header comments
+    const QRegExp expiresRegExp(QL1S("^!\\s*Expires\\s*:\\s*(\\d+)\\s*(h|d)"), Qt::CaseInsensitive);
+
+    QTextStream in(rules);
+    while (!in.atEnd())
+    {
+        const QString line = in.readLine();
+        if (!line.startsWith(QL1C('!')) && !line.startsWith(QL1C('[')))
+            break;
+
+        if (expiresRegExp.indexIn(line) < 0)
+            continue;
+
+        const int value = expiresRegExp.cap(1).toInt();
+        const int hours = (expiresRegExp.cap(2).toLower() == QL1S("h")) ? value : value * 24;
+
+        // do not let a list be downloaded too often
+        return qMax(hours, 1);
+    }
+
+    return 0;
+}
+
+
 void AdBlockManager::showSettings()
 {
     QPointer<KDialog> dialog = new KDialog();
@@ -410,12 +622,11 @@ void AdBlockManager::addCustomRule(const QString &stringRule, bool reloadPage)
 
     ruleFile.close();
 
-    // load it
-    loadRuleString(stringRule);
-
-    // eventually reload page
+    // load it, and eventually reload page when it is active
     if (reloadPage)
-        emit reloadCurrentPage();
+        _reloadPageOnRuleSetLoaded = true;
+
+    loadRuleSet();
 }
 
 
@@ -425,20 +636,42 @@ void AdBlockManager::showBlockedItemDialog()
     dialog->setCaption(i18nc("@title:window", "Blocked elements"));
     dialog->setButtons(KDialog::Ok);
 
+    // hidden elements are counted just here, on request: hiding them is up to css
+    WebPage *currentPage = 0;
+    if (rApp->mainWindow() && rApp->mainWindow()->currentTab())
+        currentPage = rApp->mainWindow()->currentTab()->page();
+
+    int hidedElements = 0;
+    if (_isHideAdsEnabled && _ruleSet && currentPage)
+        hidedElements = hiddenElementsCount(currentPage->mainFrame());
+
+    QList<qint64> classMatchTimes;
+    for (int i = 0; i < AdBlockRuleStatistics::RuleClassCount; ++i)
+    {
+        classMatchTimes << matchTime(AdBlockRuleStatistics::RuleClass(i));
+    }
+
     BlockedElementsWidget widget(this);
     widget.setBlockedElements(_blockedElements);
-    widget.setHidedElements(_hidedElements);
+    widget.setHidedElements(hidedElements);
+    widget.setRuleStatistics(ruleStatistics(), classMatchTimes, pageStatistics(currentPage));
 
     dialog->setMainWidget(&widget);
     dialog->exec();
 
     Q_FOREACH(const QString & r, widget.rulesToAdd())
     {
-        addCustomRule(r);
+        addCustomRule(r, false);
     }
 
     if (widget.pageNeedsReload())
-        emit reloadCurrentPage();
+    {
+        // wait for the new rules, if any
+        if (_ruleSetWatcher.isRunning())
+            _reloadPageOnRuleSetLoaded = true;
+        else
+            emit reloadCurrentPage();
+    }
 
     dialog->deleteLater();
 }
@@ -447,5 +680,4 @@ void AdBlockManager::showBlockedItemDialog()
 void AdBlockManager::clearElementsLists()
 {
     _blockedElements.clear();
-    _hidedElements = 0;
 }
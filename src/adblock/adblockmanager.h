@@ -118,6 +118,10 @@
 //
 // The previous rule will hide every div whose class is named "advise". Usual CSS selectors apply here :)
 //
+// RULE=example.com,~news.example.com##div.advise
+//
+// This one does the same, but just in example.com pages (news.example.com ones excluded).
+//
 // END NOTE ----------------------------------------------------------------------------------------------------------
 
 
@@ -125,8 +129,7 @@
 #include "rekonq_defines.h"
 
 // Local Includes
-#include "adblockhostmatcher.h"
-#include "adblockrule.h"
+#include "adblockruleset.h"
 
 // KDE Includes
 #include <KIO/Job>
@@ -136,15 +139,17 @@
 #include <QObject>
 #include <QStringList>
 #include <QByteArray>
+#include <QCache>
+#include <QFutureWatcher>
+#include <QList>
+#include <QSharedPointer>
 
 // Forward Includes
 class QNetworkReply;
 class QNetworkRequest;
+class QWebFrame;
 class WebPage;
 
-// Definitions
-typedef QList<AdBlockRule> AdBlockRuleList;
-
 
 class REKONQ_TESTS_EXPORT AdBlockManager : public QObject
 {
@@ -163,15 +168,35 @@ public:
     void addCustomRule(const QString &, bool reloadPage = true);
     void clearElementsLists();
 
+    // block() decision cache statistics
+    int decisionCacheHits() const;
+    int decisionCacheMisses() const;
+
+    // What the rules in use did, since they have been loaded: hits of every rule
+    // (to find the dead ones) and match times, per rule and per rule class
+    QList<AdBlockRuleStatistics> ruleStatistics() const;
+    qint64 matchTime(AdBlockRuleStatistics::RuleClass ruleClass) const;
+
+    // What adblock did for a page, since it started loading
+    AdBlockPageStatistics pageStatistics(WebPage *page) const;
+
 private:
+    // inject the hiding css in frame, and in its child frames
+    void applyHidingRules(QWebFrame *frame, WebPage *page);
+    int hiddenElementsCount(QWebFrame *frame) const;
+
+    // forget cached decisions, when rules change
+    void clearDecisionCache();
+
     void updateSubscription(int);
     bool subscriptionFileExists(int);
+    bool subscriptionNeedsUpdate(int);
 
-    // load a file rule, given a path
-    void loadRules(const QString &rulesFilePath);
+    // hours a list says it is valid for (or 0), from its "! Expires:" header
+    static int subscriptionExpiresHours(const QByteArray &rules);
 
-    // load a single rule
-    void loadRuleString(const QString &stringRule);
+    // (re)load the rule set from _rulesFiles, in a worker thread
+    void loadRuleSet();
 
 private Q_SLOTS:
     void loadSettings();
@@ -180,6 +205,8 @@ private Q_SLOTS:
 
     void slotFinished(KJob *);
 
+    void ruleSetLoaded();
+
 Q_SIGNALS:
     void reloadCurrentPage();
 
@@ -187,14 +214,20 @@ private:
     bool _isAdblockEnabled;
     bool _isHideAdsEnabled;
 
-    AdBlockHostMatcher _hostBlackList;
-    AdBlockHostMatcher _hostWhiteList;
-    AdBlockRuleList _blackList;
-    AdBlockRuleList _whiteList;
-    QStringList _hideList;
+    // The rule set currently in use. It is replaced (never changed)
+    // when a new one has been loaded by _ruleSetWatcher
+    QSharedPointer<AdBlockRuleSet> _ruleSet;
+    QFutureWatcher<AdBlockRuleSet *> _ruleSetWatcher;
+    QStringList _rulesFiles;
+    bool _ruleSetNeedsReload;
+    bool _reloadPageOnRuleSetLoaded;
+
+    // LRU cache of the last block() decisions, keyed by url, first party host and request options
+    QCache<QString, AdBlockRuleSet::Decision> _decisionCache;
+    int _decisionCacheHits;
+    int _decisionCacheMisses;
 
     QStringList _blockedElements;
-    int _hidedElements;
 
     KSharedConfig::Ptr _adblockConfig;
 };
@@ -0,0 +1,236 @@
+/* ============================================================
+*
+* This file is a part of the rekonq project
+*
+* Copyright (C) 2012 by Andrea Diamantini <adjam7 at gmail dot com>
+*
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as
+* published by the Free Software Foundation; either version 2 of
+* the License or (at your option) version 3 or any later version
+* accepted by the membership of KDE e.V. (or its successor approved
+* by the membership of KDE e.V.), which shall act as a proxy
+* defined in Section 14 of version 3 of the license.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* ============================================================ */
+// Self Includes
+#include "adblockoptions.h"
+
+// Rekonq Includes
+#include "rekonq_defines.h"
+
+// Qt Includes
+#include <QNetworkRequest>
+#include <QUrl>
+#include <QWebFrame>
+
+
+static quint16 typeOption(const QString &option)
+{
+    if (option == QL1S("other"))
+        return AdBlockOptions::OtherRequest;
+    if (option == QL1S("script"))
+        return AdBlockOptions::ScriptRequest;
+    if (option == QL1S("image") || option == QL1S("background"))
+        return AdBlockOptions::ImageRequest;
+    if (option == QL1S("stylesheet"))
+        return AdBlockOptions::StyleSheetRequest;
+    if (option == QL1S("object"))
+        return AdBlockOptions::ObjectRequest;
+    if (option == QL1S("object-subrequest"))
+        return AdBlockOptions::ObjectSubrequest;
+    if (option == QL1S("subdocument"))
+        return AdBlockOptions::SubDocumentRequest;
+    if (option == QL1S("document"))
+        return AdBlockOptions::DocumentRequest;
+    if (option == QL1S("xmlhttprequest"))
+        return AdBlockOptions::XmlHttpRequest;
+    if (option == QL1S("media"))
+        return AdBlockOptions::MediaRequest;
+    if (option == QL1S("font"))
+        return AdBlockOptions::FontRequest;
+
+    if (option == QL1S("popup")
+            || option == QL1S("elemhide")
+            || option == QL1S("xbl")
+            || option == QL1S("ping")
+            || option == QL1S("dtd"))
+        return AdBlockOptions::UnsupportedRequest;
+
+    return 0;
+}
+
+
+static quint16 extensionType(const QString &path)
+{
+    const int dot = path.lastIndexOf(QL1C('.'));
+    if (dot < 0 || path.indexOf(QL1C('/'), dot) >= 0)
+        return AdBlockOptions::OtherRequest;
+
+    const QString extension = path.mid(dot + 1).toLower();
+
+    if (extension == QL1S("js"))
+        return AdBlockOptions::ScriptRequest;
+
+    if (extension == QL1S("css"))
+        return AdBlockOptions::StyleSheetRequest;
+
+    if (extension == QL1S("png")
+            || extension == QL1S("jpg")
+            || extension == QL1S("jpeg")
+            || extension == QL1S("gif")
+            || extension == QL1S("bmp")
+            || extension == QL1S("ico")
+            || extension == QL1S("svg")
+            || extension == QL1S("webp"))
+        return AdBlockOptions::ImageRequest;
+
+    if (extension == QL1S("swf"))
+        return AdBlockOptions::ObjectRequest;
+
+    if (extension == QL1S("flv")
+            || extension == QL1S("mp3")
+            || extension == QL1S("mp4")
+            || extension == QL1S("ogg")
+            || extension == QL1S("oga")
+            || extension == QL1S("ogv")
+            || extension == QL1S("webm")
+            || extension == QL1S("wav"))
+        return AdBlockOptions::MediaRequest;
+
+    if (extension == QL1S("woff")
+            || extension == QL1S("ttf")
+            || extension == QL1S("otf")
+            || extension == QL1S("eot"))
+        return AdBlockOptions::FontRequest;
+
+    return AdBlockOptions::OtherRequest;
+}
+
+
+// QtWebKit does not tell us which element started a request: what we have are
+// the frame starting it, the Accept header WebKit chose and the url.
+static quint16 requestType(const QNetworkRequest &request, const QWebFrame *frame)
+{
+    // set by (almost) every javascript library, whatever it accepts
+    if (request.rawHeader("X-Requested-With") == "XMLHttpRequest")
+        return AdBlockOptions::XmlHttpRequest;
+
+    // A frame navigation: the frame is loading the url of the request, as
+    // requestedUrl() is set before the request is sent. Accept headers asking
+    // for html are no proof of it, as they come from scripts and plugins, too
+    if (frame && frame->requestedUrl() == request.url())
+    {
+        return frame->parentFrame()
+               ? AdBlockOptions::SubDocumentRequest
+               : AdBlockOptions::DocumentRequest;
+    }
+
+    const QByteArray accept = request.rawHeader("Accept");
+
+    if (accept.startsWith("text/css"))
+        return AdBlockOptions::StyleSheetRequest;
+
+    if (accept.startsWith("image/"))
+        return AdBlockOptions::ImageRequest;
+
+    return extensionType(request.url().path());
+}
+
+
+// The registrable domain of an url: "www.example.co.uk" --> "example.co.uk"
+static QString baseDomain(const QUrl &url)
+{
+    const QString host = url.host().toLower();
+    const QString tld = url.topLevelDomain();
+
+    // no known top level domain (eg: ip addresses, localhost)
+    if (tld.isEmpty() || host.length() <= tld.length() || !host.endsWith(tld))
+        return host;
+
+    const int dot = host.lastIndexOf(QL1C('.'), host.length() - tld.length() - 1);
+    return host.mid(dot + 1);
+}
+
+
+quint16 AdBlockOptions::ruleOptions(const QStringList &options, QStringList *otherOptions)
+{
+    quint16 types = 0;
+    quint16 excludedTypes = 0;
+    quint16 party = AnyParty;
+
+    Q_FOREACH(const QString & option, options)
+    {
+        const bool isInverse = option.startsWith(QL1C('~'));
+        const QString name = isInverse ? option.mid(1) : option;
+
+        if (name == QL1S("third-party"))
+        {
+            party = isInverse ? FirstParty : ThirdParty;
+            continue;
+        }
+
+        // they just change how blocked elements are hidden
+        if (name == QL1S("collapse"))
+            continue;
+
+        const quint16 type = typeOption(name);
+        if (!type)
+        {
+            otherOptions->append(option);
+            continue;
+        }
+
+        if (isInverse)
+            excludedTypes |= type;
+        else
+            types |= type;
+    }
+
+    if (!types)
+        types = DefaultRequestTypes;
+
+    return (types & ~excludedTypes) | party;
+}
+
+
+quint16 AdBlockOptions::requestOptions(const QNetworkRequest &request)
+{
+    const QWebFrame *frame = qobject_cast<QWebFrame *>(request.originatingObject());
+    const quint16 type = requestType(request, frame);
+
+    // pages are (first) party of themselves, frames of their parent frame
+    if (type == DocumentRequest)
+        return type | FirstParty;
+
+    QUrl firstPartyUrl;
+    if (!frame)
+        firstPartyUrl = QUrl::fromEncoded(request.rawHeader("Referer"));
+    else if (type == SubDocumentRequest)
+        firstPartyUrl = frame->parentFrame()->url();
+    else
+        firstPartyUrl = frame->url();
+
+    if (isThirdParty(request.url(), firstPartyUrl))
+        return type | ThirdParty;
+
+    return type | FirstParty;
+}
+
+
+bool AdBlockOptions::isThirdParty(const QUrl &url, const QUrl &firstPartyUrl)
+{
+    if (firstPartyUrl.host().isEmpty())
+        return false;
+
+    return baseDomain(url) != baseDomain(firstPartyUrl);
+}
@@ -0,0 +1,98 @@
+/* ============================================================
+*
+* This file is a part of the rekonq project
+*
+* Copyright (C) 2012 by Andrea Diamantini <adjam7 at gmail dot com>
+*
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as
+* published by the Free Software Foundation; either version 2 of
+* the License or (at your option) version 3 or any later version
+* accepted by the membership of KDE e.V. (or its successor approved
+* by the membership of KDE e.V.), which shall act as a proxy
+* defined in Section 14 of version 3 of the license.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* ============================================================ */
+#ifndef ADBLOCKOPTIONS_H
+#define ADBLOCKOPTIONS_H
+
+
+// Rekonq Includes
+#include "rekonq_defines.h"
+
+// Qt Includes
+#include <QString>
+#include <QStringList>
+
+// Forward Includes
+class QNetworkRequest;
+class QUrl;
+
+
+// AdBlockPlus request type and third party options, as bits.
+// A rule keeps the mask of the requests it applies to, while a request has
+// exactly one type bit and one party bit set: so checking if a rule applies
+// to a request is just a bitwise and, done before any pattern matching.
+class REKONQ_TESTS_EXPORT AdBlockOptions
+{
+public:
+    enum Option
+    {
+        OtherRequest            = 0x0001,
+        ScriptRequest           = 0x0002,
+        ImageRequest            = 0x0004,
+        StyleSheetRequest       = 0x0008,
+        ObjectRequest           = 0x0010,
+        ObjectSubrequest        = 0x0020,
+        SubDocumentRequest      = 0x0040,
+        DocumentRequest         = 0x0080,
+        XmlHttpRequest          = 0x0100,
+        MediaRequest            = 0x0200,
+        FontRequest             = 0x0400,
+
+        // types we never recognize in requests (popup, elemhide, xbl, ping, dtd)
+        UnsupportedRequest      = 0x0800,
+
+        FirstParty              = 0x4000,
+        ThirdParty              = 0x8000
+    };
+
+    // the types rules without type options apply to (everything, but page loads)
+    static const quint16 DefaultRequestTypes = OtherRequest | ScriptRequest | ImageRequest
+            | StyleSheetRequest | ObjectRequest | ObjectSubrequest | SubDocumentRequest
+            | XmlHttpRequest | MediaRequest | FontRequest;
+
+    // the types a request can be recognized as
+    static const quint16 RequestTypes = DefaultRequestTypes | DocumentRequest;
+
+    static const quint16 AnyParty = FirstParty | ThirdParty;
+
+    static const quint16 DefaultRuleOptions = DefaultRequestTypes | AnyParty;
+
+    // Parse the options of a rule (what follows the $ sign).
+    // Options not about request type and party (eg: domain=, match-case)
+    // are left in otherOptions
+    static quint16 ruleOptions(const QStringList &options, QStringList *otherOptions);
+
+    // Guess the type of the request and if it is a third party one.
+    // Requests without an originating frame are compared with their referer
+    static quint16 requestOptions(const QNetworkRequest &request);
+
+    static bool applies(quint16 ruleOptions, quint16 requestOptions)
+    {
+        return (ruleOptions & requestOptions) == requestOptions;
+    }
+
+    static bool isThirdParty(const QUrl &url, const QUrl &firstPartyUrl);
+};
+
+#endif // ADBLOCKOPTIONS_H
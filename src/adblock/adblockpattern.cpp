@@ -0,0 +1,257 @@
+/* ============================================================
+*
+* This file is a part of the rekonq project
+*
+* Copyright (C) 2012 by Andrea Diamantini <adjam7 at gmail dot com>
+*
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as
+* published by the Free Software Foundation; either version 2 of
+* the License or (at your option) version 3 or any later version
+* accepted by the membership of KDE e.V. (or its successor approved
+* by the membership of KDE e.V.), which shall act as a proxy
+* defined in Section 14 of version 3 of the license.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* ============================================================ */
+
+
+// Self Includes
+#include "adblockpattern.h"
+
+// Rekonq Includes
+#include "rekonq_defines.h"
+
+
+// Same as the [^\w\d\-.%] class used in the regular expressions
+static inline bool isSeparator(const QChar &c)
+{
+    return !(c.isLetterOrNumber()
+             || c == QL1C('_')
+             || c == QL1C('-')
+             || c == QL1C('.')
+             || c == QL1C('%'));
+}
+
+
+QString AdBlockPattern::parse(const QString &wildcardPattern, Qt::CaseSensitivity cs, quint8 *flags)
+{
+    QString pattern = wildcardPattern;
+    *flags = 0;
+
+    // anchors
+    if (pattern.startsWith(QL1S("||")))
+    {
+        *flags |= DomainAnchor;
+        pattern.remove(0, 2);
+    }
+    else if (pattern.startsWith(QL1C('|')))
+    {
+        *flags |= StartAnchor;
+        pattern.remove(0, 1);
+    }
+
+    if (pattern.endsWith(QL1C('|')))
+    {
+        *flags |= EndAnchor;
+        pattern.chop(1);
+    }
+
+    // remove multiple wildcards
+    QString segments;
+    segments.reserve(pattern.length());
+    for (int i = 0; i < pattern.length(); ++i)
+    {
+        const QChar c = pattern.at(i);
+        if (c == QL1C('*') && segments.endsWith(QL1C('*')))
+            continue;
+        segments += c;
+    }
+
+    // leading and trailing wildcards just make anchors useless
+    if (segments.startsWith(QL1C('*')))
+    {
+        *flags &= ~(DomainAnchor | StartAnchor);
+        segments.remove(0, 1);
+    }
+
+    if (segments.endsWith(QL1C('*')))
+    {
+        *flags &= ~EndAnchor;
+        segments.chop(1);
+    }
+
+    if (cs == Qt::CaseSensitive)
+        *flags |= CaseSensitive;
+    else
+        segments = segments.toLower();
+
+    return segments;
+}
+
+
+AdBlockPattern::AdBlockPattern(const QStringRef &pattern, quint8 flags)
+    : m_pattern(pattern)
+    , m_flags(flags)
+{
+}
+
+
+bool AdBlockPattern::match(const QString &encodedUrl, const QString &encodedUrlLowerCase) const
+{
+    const QString &url = (m_flags & CaseSensitive) ? encodedUrl : encodedUrlLowerCase;
+
+    if (m_flags & StartAnchor)
+        return matchFrom(url, 0, true);
+
+    if (m_flags & DomainAnchor)
+    {
+        const int schemeEnd = url.indexOf(QL1S("://"));
+        if (schemeEnd < 0)
+            return false;
+
+        // the pattern can start at the beginning of the host, or of one of its subdomains
+        const int hostStart = schemeEnd + 3;
+        if (matchFrom(url, hostStart, true))
+            return true;
+
+        const int length = url.length();
+        for (int i = hostStart; i < length; ++i)
+        {
+            const QChar c = url.at(i);
+            if (c == QL1C('/') || c == QL1C('?') || c == QL1C('#') || c == QL1C(':'))
+                break;
+
+            if (c == QL1C('.') && matchFrom(url, i + 1, true))
+                return true;
+        }
+        return false;
+    }
+
+    return matchFrom(url, 0, false);
+}
+
+
+bool AdBlockPattern::matchFrom(const QString &url, int position, bool anchored) const
+{
+    const int length = url.length();
+
+    int segmentStart = 0;
+    bool isFirst = true;
+    while (true)
+    {
+        int segmentEnd = m_pattern.indexOf(QL1C('*'), segmentStart);
+        const bool isLast = (segmentEnd < 0);
+        if (isLast)
+            segmentEnd = m_pattern.length();
+
+        const bool isAnchored = isFirst && anchored;
+
+        // last segment has to end with the url
+        if (isLast && (m_flags & EndAnchor))
+        {
+            if (isAnchored)
+                return matchSegment(url, position, segmentStart, segmentEnd) == length;
+
+            // every pattern char consumes one url char, but trailing separators at the url end
+            const int minStart = qMax(position, length - (segmentEnd - segmentStart));
+            for (int start = minStart; start <= length; ++start)
+            {
+                if (matchSegment(url, start, segmentStart, segmentEnd) == length)
+                    return true;
+            }
+            return false;
+        }
+
+        // Taking the first match of every segment is always right:
+        // it leaves the most room for the following ones
+        const int end = isAnchored
+                        ? matchSegment(url, position, segmentStart, segmentEnd)
+                        : findSegment(url, position, segmentStart, segmentEnd);
+        if (end < 0)
+            return false;
+
+        if (isLast)
+            return true;
+
+        position = end;
+        segmentStart = segmentEnd + 1;
+        isFirst = false;
+    }
+}
+
+
+int AdBlockPattern::matchSegment(const QString &url, int position, int segmentStart, int segmentEnd) const
+{
+    const int length = url.length();
+
+    for (int i = segmentStart; i < segmentEnd; ++i)
+    {
+        const QChar p = m_pattern.at(i);
+
+        if (p == QL1C('^'))
+        {
+            // url end is a separator, too
+            if (position == length)
+                continue;
+
+            if (!isSeparator(url.at(position)))
+                return -1;
+
+            ++position;
+            continue;
+        }
+
+        if (position == length || url.at(position) != p)
+            return -1;
+
+        ++position;
+    }
+
+    return position;
+}
+
+
+int AdBlockPattern::findSegment(const QString &url, int from, int segmentStart, int segmentEnd) const
+{
+    const int length = url.length();
+
+    // use the literal prefix of the segment to jump to the candidate positions
+    int prefixEnd = segmentStart;
+    while (prefixEnd < segmentEnd && m_pattern.at(prefixEnd) != QL1C('^'))
+        ++prefixEnd;
+
+    if (prefixEnd == segmentStart)
+    {
+        for (int start = from; start <= length; ++start)
+        {
+            const int end = matchSegment(url, start, segmentStart, segmentEnd);
+            if (end >= 0)
+                return end;
+        }
+        return -1;
+    }
+
+    const QStringRef prefix(m_pattern.string(), m_pattern.position() + segmentStart, prefixEnd - segmentStart);
+
+    int start = url.indexOf(prefix, from);
+    while (start >= 0)
+    {
+        const int end = matchSegment(url, start, segmentStart, segmentEnd);
+        if (end >= 0)
+            return end;
+
+        start = url.indexOf(prefix, start + 1);
+    }
+
+    return -1;
+}
+
@@ -0,0 +1,73 @@
+/* ============================================================
+*
+* This file is a part of the rekonq project
+*
+* Copyright (C) 2012 by Andrea Diamantini <adjam7 at gmail dot com>
+*
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as
+* published by the Free Software Foundation; either version 2 of
+* the License or (at your option) version 3 or any later version
+* accepted by the membership of KDE e.V. (or its successor approved
+* by the membership of KDE e.V.), which shall act as a proxy
+* defined in Section 14 of version 3 of the license.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* ============================================================ */
+
+
+#ifndef ADBLOCKPATTERN_H
+#define ADBLOCKPATTERN_H
+
+
+// Qt Includes
+#include <QString>
+
+
+// An AdBlockPlus wildcard pattern, matched without regular expressions.
+// It knows about:
+// - the * wildcard
+// - the ^ separator placeholder (anything but a letter, a digit, or one of _-.%
+//   It matches also the end of the url)
+// - the | anchors, at the start and at the end of the pattern
+// - the || domain anchor, at the start of the pattern
+class AdBlockPattern
+{
+public:
+    // Parse a wildcard pattern. Returns the segments to store and match, and sets their flags
+    static QString parse(const QString &wildcardPattern, Qt::CaseSensitivity cs, quint8 *flags);
+
+    // An already parsed pattern, from the parse() segments (wherever they are stored) and flags
+    AdBlockPattern(const QStringRef &pattern, quint8 flags);
+
+    bool match(const QString &encodedUrl, const QString &encodedUrlLowerCase) const;
+
+private:
+    enum Flag
+    {
+        DomainAnchor    = 0x01,
+        StartAnchor     = 0x02,
+        EndAnchor       = 0x04,
+        CaseSensitive   = 0x08
+    };
+
+    bool matchFrom(const QString &url, int position, bool anchored) const;
+
+    // returns where the segment match ends, or -1
+    int matchSegment(const QString &url, int position, int segmentStart, int segmentEnd) const;
+    int findSegment(const QString &url, int from, int segmentStart, int segmentEnd) const;
+
+    // segments to match, separated by *
+    QStringRef m_pattern;
+    quint8 m_flags;
+};
+
+#endif // ADBLOCKPATTERN_H
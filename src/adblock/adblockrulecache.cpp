@@ -0,0 +1,166 @@
+/* ============================================================
+*
+* This file is a part of the rekonq project
+*
+* Copyright (C) 2012 by Andrea Diamantini <adjam7 at gmail dot com>
+*
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as
+* published by the Free Software Foundation; either version 2 of
+* the License or (at your option) version 3 or any later version
+* accepted by the membership of KDE e.V. (or its successor approved
+* by the membership of KDE e.V.), which shall act as a proxy
+* defined in Section 14 of version 3 of the license.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* ============================================================ */
+
+
+// Self Includes
+#include "adblockrulecache.h"
+
+// Rekonq Includes
+#include "rekonq_defines.h"
+
+// KDE Includes
+#include <KSaveFile>
+
+// Qt Includes
+#include <QDateTime>
+#include <QDir>
+
+
+static const quint32 ADBLOCK_CACHE_MAGIC = 0x52414243; // "RABC"
+
+// NOTE: increase this every time the records or the parsed rules change
+static const quint32 ADBLOCK_CACHE_VERSION = 7;
+
+
+AdBlockRuleCache::AdBlockRuleCache(const QString &rulesFilePath, const QString &cacheDir)
+    : m_rulesFileInfo(rulesFilePath)
+    , m_map(0)
+    , m_recordCount(0)
+{
+    m_cacheFile.setFileName(QDir(cacheDir).filePath(m_rulesFileInfo.fileName()));
+
+    m_stream.setVersion(QDataStream::Qt_4_8);
+}
+
+
+AdBlockRuleCache::~AdBlockRuleCache()
+{
+    close();
+}
+
+
+bool AdBlockRuleCache::open()
+{
+    if (!m_rulesFileInfo.exists() || !m_cacheFile.exists())
+        return false;
+
+    if (!m_cacheFile.open(QFile::ReadOnly))
+    {
+        kDebug() << "Unable to open adblock cache file" << m_cacheFile.fileName();
+        return false;
+    }
+
+    const qint64 size = m_cacheFile.size();
+    m_map = m_cacheFile.map(0, size);
+    if (!m_map)
+    {
+        kDebug() << "Unable to map adblock cache file" << m_cacheFile.fileName();
+        return false;
+    }
+
+    m_data = QByteArray::fromRawData(reinterpret_cast<const char *>(m_map), size);
+    m_buffer.setBuffer(&m_data);
+    m_buffer.open(QIODevice::ReadOnly);
+    m_stream.setDevice(&m_buffer);
+
+    quint32 magic;
+    quint32 version;
+    qint64 rulesFileSize;
+    uint rulesFileTime;
+    qint64 recordsSize;
+    m_stream >> magic >> version >> rulesFileSize >> rulesFileTime >> m_recordCount >> recordsSize;
+
+    if (m_stream.status() != QDataStream::Ok
+            || magic != ADBLOCK_CACHE_MAGIC
+            || version != ADBLOCK_CACHE_VERSION)
+        return false;
+
+    // a truncated (or grown) cache is refused before loading anything from it
+    if (recordsSize != size - m_buffer.pos())
+        return false;
+
+    return rulesFileSize == m_rulesFileInfo.size()
+           && rulesFileTime == m_rulesFileInfo.lastModified().toTime_t();
+}
+
+
+QDataStream &AdBlockRuleCache::stream()
+{
+    return m_stream;
+}
+
+
+void AdBlockRuleCache::remove()
+{
+    close();
+    m_cacheFile.remove();
+}
+
+
+bool AdBlockRuleCache::save(const QByteArray &records, quint32 recordCount, const QFileInfo &rulesFileInfo)
+{
+    close();
+
+    KSaveFile saveFile(m_cacheFile.fileName());
+    if (!saveFile.open())
+    {
+        kDebug() << "Unable to open adblock cache file" << saveFile.fileName();
+        return false;
+    }
+
+    QDataStream out(&saveFile);
+    out.setVersion(QDataStream::Qt_4_8);
+    out << ADBLOCK_CACHE_MAGIC
+        << ADBLOCK_CACHE_VERSION
+        << rulesFileInfo.size()
+        << rulesFileInfo.lastModified().toTime_t()
+        << recordCount
+        << qint64(records.size());
+
+    out.writeRawData(records.constData(), records.size());
+
+    if (out.status() != QDataStream::Ok)
+    {
+        saveFile.abort();
+        return false;
+    }
+
+    return saveFile.finalize();
+}
+
+
+void AdBlockRuleCache::close()
+{
+    m_stream.setDevice(0);
+    m_buffer.close();
+
+    if (m_map)
+    {
+        m_cacheFile.unmap(m_map);
+        m_map = 0;
+    }
+
+    m_cacheFile.close();
+}
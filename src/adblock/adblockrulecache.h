@@ -0,0 +1,101 @@
+/* ============================================================
+*
+* This file is a part of the rekonq project
+*
+* Copyright (C) 2012 by Andrea Diamantini <adjam7 at gmail dot com>
+*
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as
+* published by the Free Software Foundation; either version 2 of
+* the License or (at your option) version 3 or any later version
+* accepted by the membership of KDE e.V. (or its successor approved
+* by the membership of KDE e.V.), which shall act as a proxy
+* defined in Section 14 of version 3 of the license.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* ============================================================ */
+
+
+#ifndef ADBLOCKRULECACHE_H
+#define ADBLOCKRULECACHE_H
+
+
+// Qt Includes
+#include <QBuffer>
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+
+
+// Binary cache of an adblock rules file, already parsed.
+// It is stored in the given cache dir and it is valid just until its
+// rules file changes (size or modification time), or the cache format does.
+//
+// The cache is a sequence of (section, filter [, parsed rule]) records,
+// to be read by AdBlockRuleSet::loadRulesCache()
+class AdBlockRuleCache
+{
+public:
+    enum RuleSection
+    {
+        HostWhiteRule,
+        HostBlackRule,
+        TextWhiteRule,
+        TextBlackRule,
+        WhiteRule,
+        BlackRule,
+        HideRule,
+        DomainHideRule
+    };
+
+    AdBlockRuleCache(const QString &rulesFilePath, const QString &cacheDir);
+    ~AdBlockRuleCache();
+
+    QString rulesFilePath() const
+    {
+        return m_rulesFileInfo.filePath();
+    }
+
+    // Map the cache file and check it is up to date.
+    // On success, records can be read from stream()
+    bool open();
+
+    QDataStream &stream();
+
+    // number of records in stream()
+    quint32 recordCount() const
+    {
+        return m_recordCount;
+    }
+
+    // Something went wrong reading it: just trash the cache
+    void remove();
+
+    // Write recordCount records (the data of a QDataStream) as new cache contents.
+    // rulesFileInfo is the rules file as it was before parsing it: if it
+    // changed meanwhile, the cache is stale on next open()
+    bool save(const QByteArray &records, quint32 recordCount, const QFileInfo &rulesFileInfo);
+
+private:
+    void close();
+
+    QFileInfo m_rulesFileInfo;
+    QFile m_cacheFile;
+
+    uchar *m_map;
+    QByteArray m_data;
+    QBuffer m_buffer;
+    QDataStream m_stream;
+    quint32 m_recordCount;
+};
+
+#endif // ADBLOCKRULECACHE_H
@@ -0,0 +1,304 @@
+/* ============================================================
+*
+* This file is a part of the rekonq project
+*
+* Copyright (C) 2012 by Andrea Diamantini <adjam7 at gmail dot com>
+*
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as
+* published by the Free Software Foundation; either version 2 of
+* the License or (at your option) version 3 or any later version
+* accepted by the membership of KDE e.V. (or its successor approved
+* by the membership of KDE e.V.), which shall act as a proxy
+* defined in Section 14 of version 3 of the license.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* ============================================================ */
+
+
+// Self Includes
+#include "adblockruleindex.h"
+
+// Rekonq Includes
+#include "rekonq_defines.h"
+
+// Qt Includes
+#include <QElapsedTimer>
+#include <QVarLengthArray>
+
+
+// Shorter tokens are too common to be useful as keys
+static const int minTokenLength = 3;
+
+
+static inline bool isTokenChar(const QChar &c)
+{
+    const ushort u = c.unicode();
+    return (u >= 'a' && u <= 'z') || (u >= '0' && u <= '9') || u == '%';
+}
+
+
+// Buckets are keyed by a hash of their token chars: urls are tokenized in place,
+// with no string copy. Tokens colliding share a bucket, whose rules are matched anyway
+static inline uint tokenHash(const QChar *token, int length)
+{
+    uint h = 0;
+    for (int i = 0; i < length; ++i)
+        h = 31 * h + token[i].unicode();
+    return h;
+}
+
+
+// a url has some tens of tokens: a linear scan is cheaper than a set
+static inline bool isChecked(const QVarLengthArray<uint, 64> &checkedTokens, uint token)
+{
+    for (int i = 0; i < checkedTokens.size(); ++i)
+    {
+        if (checkedTokens.at(i) == token)
+            return true;
+    }
+    return false;
+}
+
+
+// These are in (almost) every url: choose them just when there is nothing else
+static inline bool isBadToken(const QString &token)
+{
+    return token == QL1S("http")
+           || token == QL1S("https")
+           || token == QL1S("www")
+           || token == QL1S("com");
+}
+
+
+AdBlockRuleIndex::AdBlockRuleIndex()
+    : m_regExpMatchTime(0)
+{
+}
+
+
+int AdBlockRuleIndex::addRule(const QString &filter)
+{
+    const int rule = m_rules.addRule(filter);
+    addToBucket(filter, rule);
+    return rule;
+}
+
+
+int AdBlockRuleIndex::loadRule(const QString &filter, QDataStream &in)
+{
+    const int rule = m_rules.loadRule(in);
+    addToBucket(filter, rule);
+    return rule;
+}
+
+
+void AdBlockRuleIndex::saveRule(int rule, QDataStream &out) const
+{
+    m_rules.saveRule(rule, out);
+}
+
+
+int AdBlockRuleIndex::match(const QNetworkRequest &request,
+                            const QString &encodedUrl,
+                            const QString &encodedUrlLowerCase,
+                            quint16 requestOptions) const
+{
+    QVector<int>::const_iterator it;
+    for (it = m_untokenizedRules.constBegin(); it != m_untokenizedRules.constEnd(); ++it)
+    {
+        if (matchRule(*it, request, encodedUrl, encodedUrlLowerCase, requestOptions))
+            return *it;
+    }
+
+    if (m_tokenBuckets.isEmpty())
+        return -1;
+
+    // hashes of the tokens already looked up: on the stack, for all but very long urls
+    QVarLengthArray<uint, 64> checkedTokens;
+
+    const QChar *url = encodedUrlLowerCase.constData();
+    const int length = encodedUrlLowerCase.length();
+    int tokenStart = -1;
+    for (int i = 0; i <= length; ++i)
+    {
+        if (i < length && isTokenChar(url[i]))
+        {
+            if (tokenStart < 0)
+                tokenStart = i;
+            continue;
+        }
+
+        if (tokenStart < 0)
+            continue;
+
+        const int tokenLength = i - tokenStart;
+        const uint token = tokenHash(url + tokenStart, tokenLength);
+        tokenStart = -1;
+
+        if (tokenLength < minTokenLength || isChecked(checkedTokens, token))
+            continue;
+        checkedTokens.append(token);
+
+        QHash<uint, QVector<int> >::const_iterator bucket = m_tokenBuckets.constFind(token);
+        if (bucket == m_tokenBuckets.constEnd())
+            continue;
+
+        for (it = bucket->constBegin(); it != bucket->constEnd(); ++it)
+        {
+            if (matchRule(*it, request, encodedUrl, encodedUrlLowerCase, requestOptions))
+                return *it;
+        }
+    }
+
+    return -1;
+}
+
+
+int AdBlockRuleIndex::count(AdBlockRuleTable::RuleType type) const
+{
+    int n = 0;
+    for (int rule = 0; rule < m_rules.count(); ++rule)
+    {
+        if (m_rules.type(rule) == type)
+            n++;
+    }
+    return n;
+}
+
+
+void AdBlockRuleIndex::clear()
+{
+    m_rules.clear();
+    m_hits.clear();
+    m_matchTimes.clear();
+    m_regExpMatchTime = 0;
+    m_tokenBuckets.clear();
+    m_untokenizedRules.clear();
+}
+
+
+void AdBlockRuleIndex::squeeze()
+{
+    m_rules.squeeze();
+    m_hits.squeeze();
+    m_matchTimes.squeeze();
+    m_untokenizedRules.squeeze();
+}
+
+
+bool AdBlockRuleIndex::matchRule(int rule,
+                                 const QNetworkRequest &request,
+                                 const QString &encodedUrl,
+                                 const QString &encodedUrlLowerCase,
+                                 quint16 requestOptions) const
+{
+    bool matched;
+    if (m_rules.type(rule) == AdBlockRuleTable::RegExpRule)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        matched = m_rules.match(rule, request, encodedUrl, encodedUrlLowerCase, requestOptions);
+
+        const qint64 elapsed = timer.nsecsElapsed();
+        m_matchTimes[rule] += elapsed;
+        m_regExpMatchTime += elapsed;
+    }
+    else
+    {
+        matched = m_rules.match(rule, request, encodedUrl, encodedUrlLowerCase, requestOptions);
+    }
+
+    if (!matched)
+        return false;
+
+    m_hits[rule]++;
+    return true;
+}
+
+
+void AdBlockRuleIndex::addToBucket(const QString &filter, int rule)
+{
+    m_hits << 0;
+    m_matchTimes << 0;
+
+    const QString token = findToken(filter);
+    if (token.isEmpty())
+        m_untokenizedRules << rule;
+    else
+        m_tokenBuckets[tokenHash(token.constData(), token.length())] << rule;
+}
+
+
+QString AdBlockRuleIndex::findToken(const QString &filter) const
+{
+    // regular expressions cannot be tokenized, with or without options
+    // (as in AdBlockRuleTable::addRule, a "$" in a regular expression is no options one)
+    if (AdBlockRuleTable::isRegExpFilter(filter))
+        return QString();
+
+    QString pattern = filter;
+    const int optionsNumber = pattern.lastIndexOf(QL1C('$'));
+    if (optionsNumber >= 0)
+        pattern = pattern.left(optionsNumber);
+
+    if (AdBlockRuleTable::isRegExpFilter(pattern))
+        return QString();
+
+    pattern = pattern.toLower();
+
+    // A token can be used as key just when it is a whole url token:
+    // it has to follow and to be followed by a char that is not a token one
+    // (nor a wildcard, that could hide more token chars).
+    // So, tokens at the very beginning or end of the pattern are skipped.
+    QString bestToken;
+    int bestBucketSize = 0;
+
+    const int length = pattern.length();
+    int i = 0;
+    while (i < length)
+    {
+        if (isTokenChar(pattern.at(i)))
+        {
+            ++i;
+            continue;
+        }
+
+        const bool startIsSafe = (pattern.at(i) != QL1C('*'));
+        int end = i + 1;
+        while (end < length && isTokenChar(pattern.at(end)))
+            ++end;
+
+        const int tokenLength = end - i - 1;
+        if (startIsSafe
+                && end < length
+                && pattern.at(end) != QL1C('*')
+                && tokenLength >= minTokenLength)
+        {
+            const QString token = pattern.mid(i + 1, tokenLength);
+            int bucketSize = m_tokenBuckets.value(tokenHash(token.constData(), tokenLength)).count();
+            if (isBadToken(token))
+                bucketSize += 1000000;
+
+            if (bestToken.isEmpty()
+                    || bucketSize < bestBucketSize
+                    || (bucketSize == bestBucketSize && token.length() > bestToken.length()))
+            {
+                bestToken = token;
+                bestBucketSize = bucketSize;
+            }
+        }
+
+        i = end;
+    }
+
+    return bestToken;
+}
@@ -0,0 +1,130 @@
+/* ============================================================
+*
+* This file is a part of the rekonq project
+*
+* Copyright (C) 2012 by Andrea Diamantini <adjam7 at gmail dot com>
+*
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as
+* published by the Free Software Foundation; either version 2 of
+* the License or (at your option) version 3 or any later version
+* accepted by the membership of KDE e.V. (or its successor approved
+* by the membership of KDE e.V.), which shall act as a proxy
+* defined in Section 14 of version 3 of the license.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* ============================================================ */
+#ifndef ADBLOCKRULEINDEX_H
+#define ADBLOCKRULEINDEX_H
+
+
+// Local Includes
+#include "adblockruletable.h"
+
+// Qt Includes
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+// Forward Includes
+class QDataStream;
+class QNetworkRequest;
+
+
+// Rules are bucketed by one literal token (a run of [a-z0-9%] chars,
+// bounded on both sides by a separator in the filter) they need to find
+// in the url to have any chance to match.
+// At request time the url is tokenized once, and just the rules in the
+// buckets of its tokens are checked. Rules without a usable token
+// (eg: regular expressions) are checked every time.
+class AdBlockRuleIndex
+{
+public:
+    AdBlockRuleIndex();
+
+    // Parse and add a rule. Returns its number (see saveRule)
+    int addRule(const QString &filter);
+
+    // Add an already parsed rule (eg: from cache)
+    int loadRule(const QString &filter, QDataStream &in);
+    void saveRule(int rule, QDataStream &out) const;
+
+    // returns the number of the first rule matching, or -1 if none matched
+    int match(const QNetworkRequest &request,
+              const QString &encodedUrl,
+              const QString &encodedUrlLowerCase,
+              quint16 requestOptions) const;
+
+    // number of rules with the given type
+    int count(AdBlockRuleTable::RuleType type) const;
+
+    // Every rule, with its type, text (see AdBlockRuleTable::ruleString)
+    // and how many times it matched
+    int count() const
+    {
+        return m_rules.count();
+    }
+
+    AdBlockRuleTable::RuleType type(int rule) const
+    {
+        return m_rules.type(rule);
+    }
+
+    QString ruleString(int rule) const
+    {
+        return m_rules.ruleString(rule);
+    }
+
+    int hits(int rule) const
+    {
+        return m_hits.at(rule);
+    }
+
+    // Nanoseconds spent matching a regular expression rule (other rules are not timed
+    // one by one: they are many and cheap), and all of them together
+    qint64 matchTime(int rule) const
+    {
+        return m_matchTimes.at(rule);
+    }
+
+    qint64 regExpMatchTime() const
+    {
+        return m_regExpMatchTime;
+    }
+
+    void clear();
+
+    // free the room reserved for more rules, once they are all added
+    void squeeze();
+
+private:
+    void addToBucket(const QString &filter, int rule);
+    QString findToken(const QString &filter) const;
+
+    bool matchRule(int rule,
+                   const QNetworkRequest &request,
+                   const QString &encodedUrl,
+                   const QString &encodedUrlLowerCase,
+                   quint16 requestOptions) const;
+
+    AdBlockRuleTable m_rules;
+
+    // NOTE: updated on match, so an index is not meant to be shared between threads
+    mutable QVector<int> m_hits;
+    mutable QVector<qint64> m_matchTimes;
+    mutable qint64 m_regExpMatchTime;
+
+    // token hash --> rules
+    QHash<uint, QVector<int> > m_tokenBuckets;
+    QVector<int> m_untokenizedRules;
+};
+
+#endif // ADBLOCKRULEINDEX_H
@@ -0,0 +1,639 @@
+/* ============================================================
+*
+* This file is a part of the rekonq project
+*
+* Copyright (C) 2010-2012 by Andrea Diamantini <adjam7 at gmail dot com>
+*
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as
+* published by the Free Software Foundation; either version 2 of
+* the License or (at your option) version 3 or any later version
+* accepted by the membership of KDE e.V. (or its successor approved
+* by the membership of KDE e.V.), which shall act as a proxy
+* defined in Section 14 of version 3 of the license.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* ============================================================ */
+
+
+// Self Includes
+#include "adblockruleset.h"
+
+// Rekonq Includes
+#include "rekonq_defines.h"
+
+// Local Includes
+#include "adblockoptions.h"
+#include "adblockrulecache.h"
+
+// Qt Includes
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QTextStream>
+
+
+AdBlockRuleSet *AdBlockRuleSet::loadFiles(const QStringList &rulesFilePaths, const QString &cacheDir)
+{
+    AdBlockRuleSet *ruleSet = new AdBlockRuleSet;
+
+    Q_FOREACH(const QString & rulesFilePath, rulesFilePaths)
+    {
+        if (ruleSet->loadRules(rulesFilePath, cacheDir, true))
+            continue;
+
+        // A corrupted cache has added its first rules already: throw the set
+        // away and parse the rules files again, with no cache (they are saved anew)
+        delete ruleSet;
+        ruleSet = new AdBlockRuleSet;
+        Q_FOREACH(const QString & path, rulesFilePaths)
+        {
+            ruleSet->loadRules(path, cacheDir, false);
+        }
+        break;
+    }
+
+    ruleSet->build();
+    return ruleSet;
+}
+
+
+AdBlockRuleSet::AdBlockRuleSet()
+    : _hostMatchTime(0)
+    , _textMatchTime(0)
+    , _indexMatchTime(0)
+{
+}
+
+
+// Host and text rules have no type or party options
+static inline bool defaultRulesApply(quint16 requestOptions)
+{
+    return AdBlockOptions::applies(AdBlockOptions::DefaultRuleOptions, requestOptions);
+}
+
+
+AdBlockRuleSet::Decision AdBlockRuleSet::decision(const QNetworkRequest &request,
+                                                  const QString &encodedUrl,
+                                                  const QString &encodedUrlLowerCase,
+                                                  const QString &host,
+                                                  quint16 requestOptions) const
+{
+    // most requests match no black rule, and white rules matter just for the blocked ones
+    Decision decision = NotBlocked;
+    if (isHostBlackListed(host, requestOptions))
+        decision = HostBlocked;
+    else if (isBlackListed(request, encodedUrl, encodedUrlLowerCase, requestOptions))
+        decision = RuleBlocked;
+
+    // no match
+    if (decision == NotBlocked)
+        return NotBlocked;
+
+    if (isWhiteListed(request, encodedUrl, encodedUrlLowerCase, host, requestOptions))
+    {
+        kDebug() << "ADBLOCK: WHITE RULE (@@) Matched by string: " << encodedUrl;
+        return NotBlocked;
+    }
+
+    return decision;
+}
+
+
+bool AdBlockRuleSet::isWhiteListed(const QNetworkRequest &request,
+                                   const QString &encodedUrl,
+                                   const QString &encodedUrlLowerCase,
+                                   const QString &host,
+                                   quint16 requestOptions) const
+{
+    QElapsedTimer timer;
+
+    if (defaultRulesApply(requestOptions))
+    {
+        timer.start();
+        const bool hostMatched = _hostWhiteList.match(host);
+        _hostMatchTime += timer.nsecsElapsed();
+        if (hostMatched)
+            return true;
+
+        timer.start();
+        const bool textMatched = _textWhiteList.match(encodedUrlLowerCase);
+        _textMatchTime += timer.nsecsElapsed();
+        if (textMatched)
+            return true;
+    }
+
+    timer.start();
+    const bool matched = _whiteList.match(request, encodedUrl, encodedUrlLowerCase, requestOptions) >= 0;
+    _indexMatchTime += timer.nsecsElapsed();
+    return matched;
+}
+
+
+bool AdBlockRuleSet::isHostBlackListed(const QString &host, quint16 requestOptions) const
+{
+    if (!defaultRulesApply(requestOptions))
+        return false;
+
+    QElapsedTimer timer;
+    timer.start();
+    const bool matched = _hostBlackList.match(host);
+    _hostMatchTime += timer.nsecsElapsed();
+    return matched;
+}
+
+
+QStringList AdBlockRuleSet::hideRules(const QString &host) const
+{
+    const QSet<QString> exceptions = hideExceptions(host);
+    if (exceptions.isEmpty())
+        return _hideList;
+
+    QStringList hiddenSelectors;
+    Q_FOREACH(const QString & selector, _hideList)
+    {
+        if (!exceptions.contains(selector))
+            hiddenSelectors << selector;
+    }
+    return hiddenSelectors;
+}
+
+
+QString AdBlockRuleSet::hideStyleSheet(const QString &host) const
+{
+    // just when some generic selectors are excepted there, the css built once is no good
+    const QStringList selectors = hideRules(host);
+    if (selectors.count() == _hideList.count())
+        return _hideStyleSheet;
+
+    return buildHideStyleSheet(selectors);
+}
+
+
+QStringList AdBlockRuleSet::domainHideRules(const QString &host) const
+{
+    QStringList selectors;
+
+    QString domain = host;
+    while (!domain.isEmpty())
+    {
+        selectors << _domainHideList.value(domain);
+
+        const int dot = domain.indexOf(QL1C('.'));
+        if (dot < 0)
+            break;
+        domain = domain.mid(dot + 1);
+    }
+
+    const QSet<QString> exceptions = hideExceptions(host);
+    if (exceptions.isEmpty() && _hideExceptions.isEmpty())
+        return selectors;
+
+    QStringList hiddenSelectors;
+    Q_FOREACH(const QString & selector, selectors)
+    {
+        if (!exceptions.contains(selector) && !_hideExceptions.contains(selector))
+            hiddenSelectors << selector;
+    }
+    return hiddenSelectors;
+}
+
+
+QSet<QString> AdBlockRuleSet::hideExceptions(const QString &host) const
+{
+    QSet<QString> exceptions;
+
+    QString domain = host;
+    while (!domain.isEmpty())
+    {
+        Q_FOREACH(const QString & selector, _domainHideExceptions.value(domain))
+        {
+            exceptions.insert(selector);
+        }
+
+        const int dot = domain.indexOf(QL1C('.'));
+        if (dot < 0)
+            break;
+        domain = domain.mid(dot + 1);
+    }
+
+    return exceptions;
+}
+
+
+// Selectors are pasted in a <style> element: they cannot close it, nor the css rule they are in
+bool AdBlockRuleSet::isValidSelector(const QString &selector)
+{
+    return !selector.isEmpty()
+           && !selector.contains(QL1C('<'))
+           && !selector.contains(QL1C('{'))
+           && !selector.contains(QL1C('}'));
+}
+
+
+QString AdBlockRuleSet::buildHideStyleSheet(const QStringList &selectors)
+{
+    // One css rule per selector: an invalid selector (there are, in lists)
+    // makes WebKit drop the whole rule it is in.
+    QString styleSheet;
+    Q_FOREACH(const QString & selector, selectors)
+    {
+        styleSheet += selector + QL1S(" { display: none !important; }\n");
+    }
+    return styleSheet;
+}
+
+
+bool AdBlockRuleSet::isBlackListed(const QNetworkRequest &request,
+                                   const QString &encodedUrl,
+                                   const QString &encodedUrlLowerCase,
+                                   quint16 requestOptions) const
+{
+    QElapsedTimer timer;
+
+    if (defaultRulesApply(requestOptions))
+    {
+        timer.start();
+        const bool textMatched = _textBlackList.match(encodedUrlLowerCase);
+        _textMatchTime += timer.nsecsElapsed();
+        if (textMatched)
+            return true;
+    }
+
+    timer.start();
+    const bool matched = _blackList.match(request, encodedUrl, encodedUrlLowerCase, requestOptions) >= 0;
+    _indexMatchTime += timer.nsecsElapsed();
+    return matched;
+}
+
+
+int AdBlockRuleSet::hostRulesCount() const
+{
+    return _hostWhiteList.count() + _hostBlackList.count();
+}
+
+
+int AdBlockRuleSet::textRulesCount() const
+{
+    return _textWhiteList.count() + _textBlackList.count();
+}
+
+
+int AdBlockRuleSet::indexedRulesCount(AdBlockRuleTable::RuleType type) const
+{
+    return _whiteList.count(type) + _blackList.count(type);
+}
+
+
+int AdBlockRuleSet::hideRulesCount() const
+{
+    int count = _hideList.count();
+    Q_FOREACH(const QStringList & selectors, _domainHideList)
+    {
+        count += selectors.count();
+    }
+    return count;
+}
+
+
+static void addHostRuleStatistics(QList<AdBlockRuleStatistics> &statistics,
+                                  const AdBlockHostMatcher &matcher,
+                                  bool isWhiteRule)
+{
+    for (int filter = 0; filter < matcher.count(); ++filter)
+    {
+        AdBlockRuleStatistics ruleStatistics;
+        ruleStatistics.rule = QL1S("||") + matcher.domain(filter) + QL1C('^');
+        ruleStatistics.ruleClass = AdBlockRuleStatistics::HostRule;
+        ruleStatistics.isWhiteRule = isWhiteRule;
+        ruleStatistics.hits = matcher.hits(filter);
+        ruleStatistics.matchTime = 0;
+        statistics << ruleStatistics;
+    }
+}
+
+
+static void addTextRuleStatistics(QList<AdBlockRuleStatistics> &statistics,
+                                  const AdBlockTextMatcher &matcher,
+                                  bool isWhiteRule)
+{
+    for (int filter = 0; filter < matcher.count(); ++filter)
+    {
+        AdBlockRuleStatistics ruleStatistics;
+        ruleStatistics.rule = matcher.pattern(filter);
+        ruleStatistics.ruleClass = AdBlockRuleStatistics::TextRule;
+        ruleStatistics.isWhiteRule = isWhiteRule;
+        ruleStatistics.hits = matcher.hits(filter);
+        ruleStatistics.matchTime = 0;
+        statistics << ruleStatistics;
+    }
+}
+
+
+static void addIndexedRuleStatistics(QList<AdBlockRuleStatistics> &statistics,
+                                     const AdBlockRuleIndex &index,
+                                     bool isWhiteRule)
+{
+    for (int rule = 0; rule < index.count(); ++rule)
+    {
+        AdBlockRuleStatistics ruleStatistics;
+        ruleStatistics.rule = index.ruleString(rule);
+        ruleStatistics.ruleClass = (index.type(rule) == AdBlockRuleTable::RegExpRule)
+                                   ? AdBlockRuleStatistics::RegExpRule
+                                   : AdBlockRuleStatistics::PatternRule;
+        ruleStatistics.isWhiteRule = isWhiteRule;
+        ruleStatistics.hits = index.hits(rule);
+        ruleStatistics.matchTime = index.matchTime(rule);
+        statistics << ruleStatistics;
+    }
+}
+
+
+QList<AdBlockRuleStatistics> AdBlockRuleSet::ruleStatistics() const
+{
+    QList<AdBlockRuleStatistics> statistics;
+
+    addHostRuleStatistics(statistics, _hostWhiteList, true);
+    addHostRuleStatistics(statistics, _hostBlackList, false);
+    addTextRuleStatistics(statistics, _textWhiteList, true);
+    addTextRuleStatistics(statistics, _textBlackList, false);
+    addIndexedRuleStatistics(statistics, _whiteList, true);
+    addIndexedRuleStatistics(statistics, _blackList, false);
+
+    return statistics;
+}
+
+
+qint64 AdBlockRuleSet::matchTime(AdBlockRuleStatistics::RuleClass ruleClass) const
+{
+    const qint64 regExpMatchTime = _whiteList.regExpMatchTime() + _blackList.regExpMatchTime();
+
+    switch (ruleClass)
+    {
+    case AdBlockRuleStatistics::HostRule:
+        return _hostMatchTime;
+
+    case AdBlockRuleStatistics::TextRule:
+        return _textMatchTime;
+
+    case AdBlockRuleStatistics::PatternRule:
+        // the index match time, but the regular expressions one
+        return _indexMatchTime - regExpMatchTime;
+
+    case AdBlockRuleStatistics::RegExpRule:
+        return regExpMatchTime;
+
+    default:
+        return 0;
+    }
+}
+
+
+bool AdBlockRuleSet::loadRules(const QString &rulesFilePath, const QString &cacheDir, bool useCache)
+{
+    AdBlockRuleCache ruleCache(rulesFilePath, cacheDir);
+    if (useCache && ruleCache.open())
+        return loadRulesCache(ruleCache);
+
+    // stat the rules file before reading it (QFileInfo caches it): a rule
+    // added while parsing must leave the cache stale, not up to date
+    QFileInfo rulesFileInfo(rulesFilePath);
+    rulesFileInfo.size();
+    rulesFileInfo.lastModified();
+
+    QFile ruleFile(rulesFilePath);
+    if (!ruleFile.open(QFile::ReadOnly | QFile::Text))
+    {
+        kDebug() << "Unable to open rule file" << rulesFilePath;
+        return true;
+    }
+
+    QByteArray cacheData;
+    QDataStream cache(&cacheData, QIODevice::WriteOnly);
+    cache.setVersion(QDataStream::Qt_4_8);
+
+    quint32 recordCount = 0;
+    QTextStream in(&ruleFile);
+    while (!in.atEnd())
+    {
+        QString stringRule = in.readLine();
+        const int cacheSize = cacheData.size();
+        loadRuleString(stringRule, &cache);
+        if (cacheData.size() != cacheSize)
+            ++recordCount;
+    }
+
+    // save parsed rules, to not parse them again on next load
+    ruleCache.save(cacheData, recordCount, rulesFileInfo);
+    return true;
+}
+
+
+bool AdBlockRuleSet::loadRulesCache(AdBlockRuleCache &cache)
+{
+    QDataStream &in = cache.stream();
+    quint32 recordCount = 0;
+    while (!in.atEnd())
+    {
+        quint8 section;
+        QString filter;
+        in >> section >> filter;
+
+        switch (section)
+        {
+        case AdBlockRuleCache::HostWhiteRule:
+            _hostWhiteList.tryAddFilter(filter);
+            break;
+        case AdBlockRuleCache::HostBlackRule:
+            _hostBlackList.tryAddFilter(filter);
+            break;
+        case AdBlockRuleCache::TextWhiteRule:
+            _textWhiteList.tryAddFilter(filter);
+            break;
+        case AdBlockRuleCache::TextBlackRule:
+            _textBlackList.tryAddFilter(filter);
+            break;
+        case AdBlockRuleCache::WhiteRule:
+            _whiteList.loadRule(filter, in);
+            break;
+        case AdBlockRuleCache::BlackRule:
+            _blackList.loadRule(filter, in);
+            break;
+        case AdBlockRuleCache::HideRule:
+            _hideList << filter;
+            break;
+        case AdBlockRuleCache::DomainHideRule:
+            addDomainHideRule(filter);
+            break;
+        default:
+            in.setStatus(QDataStream::ReadCorruptData);
+            break;
+        }
+
+        if (in.status() != QDataStream::Ok)
+            break;
+
+        ++recordCount;
+    }
+
+    // The cache size is checked on open(), so this is a corrupted record
+    if (in.status() != QDataStream::Ok || recordCount != cache.recordCount())
+    {
+        kDebug() << "Corrupted adblock cache for rule file" << cache.rulesFilePath();
+        cache.remove();
+        return false;
+    }
+
+    return true;
+}
+
+
+void AdBlockRuleSet::loadRuleString(const QString &stringRule, QDataStream *cache)
+{
+    // ! rules are comments
+    if (stringRule.startsWith('!'))
+        return;
+
+    // [ rules are ABP info
+    if (stringRule.startsWith('['))
+        return;
+
+    // empty rules are just dangerous..
+    // (an empty rule in whitelist allows all, in blacklist blocks all..)
+    if (stringRule.isEmpty())
+        return;
+
+    // white rules
+    if (stringRule.startsWith(QL1S("@@")))
+    {
+        const QString filter = stringRule.mid(2);
+        if (_hostWhiteList.tryAddFilter(filter))
+        {
+            if (cache)
+                *cache << quint8(AdBlockRuleCache::HostWhiteRule) << filter;
+            return;
+        }
+
+        if (_textWhiteList.tryAddFilter(filter))
+        {
+            if (cache)
+                *cache << quint8(AdBlockRuleCache::TextWhiteRule) << filter;
+            return;
+        }
+
+        const int rule = _whiteList.addRule(filter);
+        if (cache)
+        {
+            *cache << quint8(AdBlockRuleCache::WhiteRule) << filter;
+            _whiteList.saveRule(rule, *cache);
+        }
+        return;
+    }
+
+    // hide (CSS) rules
+    if (stringRule.startsWith(QL1S("##")))
+    {
+        const QString selector = stringRule.mid(2);
+        if (!isValidSelector(selector))
+            return;
+
+        _hideList << selector;
+        if (cache)
+            *cache << quint8(AdBlockRuleCache::HideRule) << selector;
+        return;
+    }
+
+    // domain specific hide rules, and their exceptions
+    if (stringRule.contains(QL1S("##")) || stringRule.contains(QL1S("#@#")))
+    {
+        if (addDomainHideRule(stringRule) && cache)
+            *cache << quint8(AdBlockRuleCache::DomainHideRule) << stringRule;
+        return;
+    }
+
+    if (_hostBlackList.tryAddFilter(stringRule))
+    {
+        if (cache)
+            *cache << quint8(AdBlockRuleCache::HostBlackRule) << stringRule;
+        return;
+    }
+
+    if (_textBlackList.tryAddFilter(stringRule))
+    {
+        if (cache)
+            *cache << quint8(AdBlockRuleCache::TextBlackRule) << stringRule;
+        return;
+    }
+
+    const int rule = _blackList.addRule(stringRule);
+    if (cache)
+    {
+        *cache << quint8(AdBlockRuleCache::BlackRule) << stringRule;
+        _blackList.saveRule(rule, *cache);
+    }
+}
+
+
+bool AdBlockRuleSet::addDomainHideRule(const QString &stringRule)
+{
+    const bool isException = stringRule.contains(QL1S("#@#"));
+    const int separator = stringRule.indexOf(isException ? QL1S("#@#") : QL1S("##"));
+    const QString selector = stringRule.mid(separator + (isException ? 3 : 2));
+
+    if (!isValidSelector(selector))
+        return false;
+
+    // generic exceptions (#@#selector) are dropped from the generic selectors on build()
+    const QStringList domains = stringRule.left(separator).toLower().split(QL1C(','), QString::SkipEmptyParts);
+    if (domains.isEmpty())
+    {
+        if (isException)
+            _hideExceptions.insert(selector);
+        return isException;
+    }
+
+    // NOTE: rules with just ~domains (hide everywhere, but there) hide nothing:
+    // their selectors are just excepted on those domains
+    Q_FOREACH(const QString & domain, domains)
+    {
+        if (domain.startsWith(QL1C('~')))
+            _domainHideExceptions[domain.mid(1)] << selector;
+        else if (isException)
+            _domainHideExceptions[domain] << selector;
+        else
+            _domainHideList[domain] << selector;
+    }
+    return true;
+}
+
+
+void AdBlockRuleSet::build()
+{
+    _textWhiteList.build();
+    _textBlackList.build();
+    _whiteList.squeeze();
+    _blackList.squeeze();
+
+    if (!_hideExceptions.isEmpty())
+    {
+        QStringList hideList;
+        Q_FOREACH(const QString & selector, _hideList)
+        {
+            if (!_hideExceptions.contains(selector))
+                hideList << selector;
+        }
+        _hideList = hideList;
+    }
+
+    _hideStyleSheet = buildHideStyleSheet(_hideList);
+}
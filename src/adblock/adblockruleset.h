@@ -0,0 +1,167 @@
+/* ============================================================
+*
+* This file is a part of the rekonq project
+*
+* Copyright (C) 2012 by Andrea Diamantini <adjam7 at gmail dot com>
+*
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as
+* published by the Free Software Foundation; either version 2 of
+* the License or (at your option) version 3 or any later version
+* accepted by the membership of KDE e.V. (or its successor approved
+* by the membership of KDE e.V.), which shall act as a proxy
+* defined in Section 14 of version 3 of the license.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* ============================================================ */
+
+
+#ifndef ADBLOCKRULESET_H
+#define ADBLOCKRULESET_H
+
+
+// Rekonq Includes
+#include "rekonq_defines.h"
+
+// Local Includes
+#include "adblockhostmatcher.h"
+#include "adblockruleindex.h"
+#include "adblockstatistics.h"
+#include "adblocktextmatcher.h"
+
+// Qt Includes
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+// Forward Includes
+class AdBlockRuleCache;
+class QDataStream;
+class QNetworkRequest;
+
+
+// A complete set of adblock rules, loaded from rules files.
+// It is built in a worker thread (see loadFiles) and never changed
+// after: AdBlockManager just swaps it with a new one when rules change.
+// Just its statistics (rule hits, match times) are updated while matching,
+// so it has to be used from one thread at a time.
+class REKONQ_TESTS_EXPORT AdBlockRuleSet
+{
+public:
+    // Load (and compile) all the rules in the given files, using their
+    // binary caches in cacheDir when valid. This is meant to run in a worker thread.
+    static AdBlockRuleSet *loadFiles(const QStringList &rulesFilePaths, const QString &cacheDir);
+
+    enum Decision
+    {
+        NotBlocked,
+        HostBlocked,
+        RuleBlocked
+    };
+
+    // What the rules say about a request: black rules first, the cheap host ones
+    // before the others, then the white ones (@@) just for the blocked requests.
+    // This is what AdBlockManager::block() does: tests and benchmarks call it, too
+    Decision decision(const QNetworkRequest &request,
+                      const QString &encodedUrl,
+                      const QString &encodedUrlLowerCase,
+                      const QString &host,
+                      quint16 requestOptions) const;
+
+    // requestOptions are the AdBlockOptions of the request
+    bool isWhiteListed(const QNetworkRequest &request,
+                       const QString &encodedUrl,
+                       const QString &encodedUrlLowerCase,
+                       const QString &host,
+                       quint16 requestOptions) const;
+
+    bool isHostBlackListed(const QString &host, quint16 requestOptions) const;
+
+    bool isBlackListed(const QNetworkRequest &request,
+                       const QString &encodedUrl,
+                       const QString &encodedUrlLowerCase,
+                       quint16 requestOptions) const;
+
+    // generic hide rules (selectors) in the pages of host, and the css hiding their
+    // elements: both without the selectors excepted there, by domain#@#selector rules
+    QStringList hideRules(const QString &host) const;
+    QString hideStyleSheet(const QString &host) const;
+
+    // selectors of the domain specific hide rules for host (and its parent domains)
+    QStringList domainHideRules(const QString &host) const;
+
+    // the css hiding (with display: none) the elements matched by the selectors
+    static QString buildHideStyleSheet(const QStringList &selectors);
+
+    // Number of loaded rules, by kind: host, (automaton) text,
+    // indexed ones by implementation type, and hide ones
+    int hostRulesCount() const;
+    int textRulesCount() const;
+    int indexedRulesCount(AdBlockRuleTable::RuleType type) const;
+    int hideRulesCount() const;
+
+    // hits (and match time, for regular expressions) of every url rule. Rules never
+    // matching are there, too: they are dead, or shadowed by other ones
+    QList<AdBlockRuleStatistics> ruleStatistics() const;
+
+    // nanoseconds spent matching the rules of a class
+    qint64 matchTime(AdBlockRuleStatistics::RuleClass ruleClass) const;
+
+private:
+    AdBlockRuleSet();
+
+    // load a file rule, given a path. False when its cache was corrupted:
+    // some of its rules are loaded, and the set has to be loaded again
+    bool loadRules(const QString &rulesFilePath, const QString &cacheDir, bool useCache);
+
+    // load (already parsed) rules from the binary cache of a rules file.
+    // False (and the cache removed) when it is corrupted
+    bool loadRulesCache(AdBlockRuleCache &cache);
+
+    // load a single rule, eventually saving the parsed rule in cache
+    void loadRuleString(const QString &stringRule, QDataStream *cache = 0);
+
+    // index a domain##selector (or [domain]#@#selector) rule. False when it is not valid
+    bool addDomainHideRule(const QString &stringRule);
+
+    // the selectors excepted on host (and its parent domains)
+    QSet<QString> hideExceptions(const QString &host) const;
+
+    static bool isValidSelector(const QString &selector);
+
+    // compile text matchers and hiding css, after loading rules
+    void build();
+
+    AdBlockHostMatcher _hostBlackList;
+    AdBlockHostMatcher _hostWhiteList;
+    AdBlockTextMatcher _textBlackList;
+    AdBlockTextMatcher _textWhiteList;
+    AdBlockRuleIndex _blackList;
+    AdBlockRuleIndex _whiteList;
+    QStringList _hideList;
+    QString _hideStyleSheet;
+
+    // domain --> selectors hidden in its pages (and not hidden, for exceptions)
+    QHash<QString, QStringList> _domainHideList;
+    QHash<QString, QStringList> _domainHideExceptions;
+
+    // selectors not hidden anywhere (#@#selector rules)
+    QSet<QString> _hideExceptions;
+
+    // host, text and indexed rules match times (regular expressions are timed by the indexes)
+    mutable qint64 _hostMatchTime;
+    mutable qint64 _textMatchTime;
+    mutable qint64 _indexMatchTime;
+};
+
+#endif // ADBLOCKRULESET_H
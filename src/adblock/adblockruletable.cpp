@@ -0,0 +1,342 @@
+/* ============================================================
+*
+* This file is a part of the rekonq project
+*
+* Copyright (C) 2012 by Andrea Diamantini <adjam7 at gmail dot com>
+*
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as
+* published by the Free Software Foundation; either version 2 of
+* the License or (at your option) version 3 or any later version
+* accepted by the membership of KDE e.V. (or its successor approved
+* by the membership of KDE e.V.), which shall act as a proxy
+* defined in Section 14 of version 3 of the license.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* ============================================================ */
+// Self Includes
+#include "adblockruletable.h"
+
+// Rekonq Includes
+#include "rekonq_defines.h"
+
+// Local Includes
+#include "adblockoptions.h"
+#include "adblockpattern.h"
+#include "adblocktextmatcher.h"
+
+// Qt Includes
+#include <QDataStream>
+#include <QNetworkRequest>
+#include <QStringList>
+#include <QWebFrame>
+
+
+// Is host the domain, or one of its subdomains?
+static inline bool isSubdomain(const QString &host, const QStringRef &domain)
+{
+    if (!host.endsWith(domain))
+        return false;
+
+    const int dot = host.length() - domain.length() - 1;
+    return dot < 0 || host.at(dot) == QL1C('.');
+}
+
+
+int AdBlockRuleTable::addRule(const QString &filter)
+{
+    Rule rule;
+    rule.type = NullRule;
+    rule.patternFlags = 0;
+    rule.options = AdBlockOptions::DefaultRuleOptions;
+    rule.pattern = -1;
+    rule.firstDomain = m_domains.count();
+    rule.domainCount = 0;
+
+    QString pattern = filter;
+    Qt::CaseSensitivity caseSensitivity = Qt::CaseInsensitive;
+
+    const int optionsNumber = filter.lastIndexOf(QL1C('$'));
+    if (optionsNumber >= 0 && !isRegExpFilter(filter))
+    {
+        QStringList otherOptions;
+        rule.options = AdBlockOptions::ruleOptions(filter.mid(optionsNumber + 1).split(QL1C(',')), &otherOptions);
+        pattern = filter.left(optionsNumber);
+
+        Q_FOREACH(const QString & option, otherOptions)
+        {
+            if (option == QL1S("match-case"))
+            {
+                caseSensitivity = Qt::CaseSensitive;
+                continue;
+            }
+
+            // Domain restricted filter
+            const QString domainKeyword(QL1S("domain="));
+            if (option.startsWith(domainKeyword))
+            {
+                const QStringList domainList = option.mid(domainKeyword.length()).split(QL1C('|'), QString::SkipEmptyParts);
+                Q_FOREACH(const QString & domain, domainList)
+                {
+                    addDomain(rule, domain.toLower());
+                }
+            }
+        }
+    }
+
+    if (!(rule.options & AdBlockOptions::RequestTypes))
+    {
+        // a rule for requests we never recognize: it never matches
+        rule.type = NullRule;
+    }
+    else if (isRegExpFilter(pattern))
+    {
+        rule.type = RegExpRule;
+        rule.pattern = m_regExps.count();
+        m_regExps << QRegExp(pattern.mid(1, pattern.length() - 2), caseSensitivity, QRegExp::RegExp2);
+    }
+    else if (caseSensitivity == Qt::CaseInsensitive && AdBlockTextMatcher::isTextMatchFilter(pattern))
+    {
+        QString text = pattern.toLower();
+        text.remove(QL1C('*'));
+
+        rule.type = TextRule;
+        rule.pattern = intern(text);
+    }
+    else
+    {
+        rule.type = PatternRule;
+        rule.pattern = intern(AdBlockPattern::parse(pattern, caseSensitivity, &rule.patternFlags));
+    }
+
+    m_rules << rule;
+    return m_rules.count() - 1;
+}
+
+
+int AdBlockRuleTable::loadRule(QDataStream &in)
+{
+    Rule rule;
+    in >> rule.type >> rule.patternFlags >> rule.options;
+
+    rule.pattern = -1;
+    rule.firstDomain = m_domains.count();
+    rule.domainCount = 0;
+
+    switch (rule.type)
+    {
+    case TextRule:
+    case PatternRule:
+    {
+        QString pattern;
+        in >> pattern;
+        rule.pattern = intern(pattern);
+        break;
+    }
+
+    case RegExpRule:
+    {
+        QRegExp regExp;
+        in >> regExp;
+        rule.pattern = m_regExps.count();
+        m_regExps << regExp;
+        break;
+    }
+
+    case NullRule:
+        break;
+
+    default:
+        rule.type = NullRule;
+        in.setStatus(QDataStream::ReadCorruptData);
+        break;
+    }
+
+    qint32 domainCount;
+    in >> domainCount;
+    for (int i = 0; i < domainCount; ++i)
+    {
+        QString domain;
+        in >> domain;
+        addDomain(rule, domain);
+    }
+
+    m_rules << rule;
+    return m_rules.count() - 1;
+}
+
+
+void AdBlockRuleTable::saveRule(int ruleNumber, QDataStream &out) const
+{
+    const Rule &rule = m_rules.at(ruleNumber);
+    out << rule.type << rule.patternFlags << rule.options;
+
+    if (rule.type == TextRule || rule.type == PatternRule)
+        out << string(rule.pattern).toString();
+    else if (rule.type == RegExpRule)
+        out << m_regExps.at(rule.pattern);
+
+    out << qint32(rule.domainCount);
+    for (int i = rule.firstDomain; i < rule.firstDomain + rule.domainCount; ++i)
+    {
+        const int domain = m_domains.at(i);
+        if (domain < 0)
+            out << (QL1C('~') + string(-domain - 1).toString());
+        else
+            out << string(domain).toString();
+    }
+}
+
+
+bool AdBlockRuleTable::match(int ruleNumber,
+                             const QNetworkRequest &request,
+                             const QString &encodedUrl,
+                             const QString &encodedUrlLowerCase,
+                             quint16 requestOptions) const
+{
+    const Rule &rule = m_rules.at(ruleNumber);
+
+    // cheap check first: is this rule about this kind of request?
+    if (!AdBlockOptions::applies(rule.options, requestOptions))
+        return false;
+
+    bool matched;
+    switch (rule.type)
+    {
+    case TextRule:
+        // the text is lowercase: compare it with the lowercase url
+        matched = encodedUrlLowerCase.contains(string(rule.pattern), Qt::CaseSensitive);
+        break;
+
+    case PatternRule:
+        matched = AdBlockPattern(string(rule.pattern), rule.patternFlags).match(encodedUrl, encodedUrlLowerCase);
+        break;
+
+    case RegExpRule:
+        matched = m_regExps.at(rule.pattern).indexIn(encodedUrl) != -1;
+        break;
+
+    case NullRule:
+    default:
+        return false;
+    }
+
+    if (!matched || !rule.domainCount)
+        return matched;
+
+    return matchDomains(rule, request);
+}
+
+
+QString AdBlockRuleTable::ruleString(int ruleNumber) const
+{
+    const Rule &rule = m_rules.at(ruleNumber);
+
+    switch (rule.type)
+    {
+    case TextRule:
+    case PatternRule:
+        return string(rule.pattern).toString();
+
+    case RegExpRule:
+        return m_regExps.at(rule.pattern).pattern();
+
+    case NullRule:
+    default:
+        return QString();
+    }
+}
+
+
+void AdBlockRuleTable::clear()
+{
+    m_rules.clear();
+    m_stringData.clear();
+    m_strings.clear();
+    m_stringIds.clear();
+    m_domains.clear();
+    m_regExps.clear();
+}
+
+
+void AdBlockRuleTable::squeeze()
+{
+    m_rules.squeeze();
+    m_stringData.squeeze();
+    m_strings.squeeze();
+    m_domains.squeeze();
+    m_regExps.squeeze();
+}
+
+
+int AdBlockRuleTable::intern(const QString &newString)
+{
+    const uint hash = qHash(newString);
+
+    QMultiHash<uint, int>::const_iterator it = m_stringIds.constFind(hash);
+    for (; it != m_stringIds.constEnd() && it.key() == hash; ++it)
+    {
+        if (string(it.value()) == newString)
+            return it.value();
+    }
+
+    StringSpan span;
+    span.position = m_stringData.length();
+    span.length = newString.length();
+    m_stringData += newString;
+
+    const int id = m_strings.count();
+    m_strings << span;
+    m_stringIds.insert(hash, id);
+    return id;
+}
+
+
+void AdBlockRuleTable::addDomain(Rule &rule, const QString &domain)
+{
+    // domains of a rule are added all together, so they are contiguous
+    Q_ASSERT(rule.firstDomain + rule.domainCount == m_domains.count());
+
+    if (domain.startsWith(QL1C('~')))
+        m_domains << -intern(domain.mid(1)) - 1;
+    else
+        m_domains << intern(domain);
+
+    rule.domainCount++;
+}
+
+
+bool AdBlockRuleTable::matchDomains(const Rule &rule, const QNetworkRequest &request) const
+{
+    const QWebFrame *const origin = qobject_cast<QWebFrame *>(request.originatingObject());
+    const QString originDomain = origin ? origin->url().host().toLower() : QString();
+
+    // The rule applies just on pages from its domains (when there are),
+    // and never on pages from its ~domains
+    bool hasDomains = false;
+    bool isFromDomains = false;
+    for (int i = rule.firstDomain; i < rule.firstDomain + rule.domainCount; ++i)
+    {
+        const int domain = m_domains.at(i);
+        if (domain < 0)
+        {
+            if (isSubdomain(originDomain, string(-domain - 1)))
+                return false;
+            continue;
+        }
+
+        hasDomains = true;
+        if (!isFromDomains && isSubdomain(originDomain, string(domain)))
+            isFromDomains = true;
+    }
+
+    return !hasDomains || isFromDomains;
+}
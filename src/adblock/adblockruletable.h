@@ -0,0 +1,140 @@
+/* ============================================================
+*
+* This file is a part of the rekonq project
+*
+* Copyright (C) 2012 by Andrea Diamantini <adjam7 at gmail dot com>
+*
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as
+* published by the Free Software Foundation; either version 2 of
+* the License or (at your option) version 3 or any later version
+* accepted by the membership of KDE e.V. (or its successor approved
+* by the membership of KDE e.V.), which shall act as a proxy
+* defined in Section 14 of version 3 of the license.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* ============================================================ */
+#ifndef ADBLOCKRULETABLE_H
+#define ADBLOCKRULETABLE_H
+
+
+// Rekonq Includes
+#include "rekonq_defines.h"
+
+// Qt Includes
+#include <QHash>
+#include <QRegExp>
+#include <QString>
+#include <QVector>
+
+// Forward Includes
+class QDataStream;
+class QNetworkRequest;
+
+
+// All the parsed (url) rules, stored in flat tables and referred by their number.
+// Patterns and domains are interned, one after the other, in one string buffer,
+// and rules are matched switching on their type: no per rule allocations (but
+// for regular expressions, one QRegExp each), nor virtual calls.
+class AdBlockRuleTable
+{
+public:
+    enum RuleType
+    {
+        TextRule,       // plain text, found (lowercase) in the url
+        PatternRule,    // AdBlockPlus wildcard pattern
+        RegExpRule,     // /regular expression/
+        NullRule        // never matches
+    };
+
+    // Is filter (or the pattern of a filter, options stripped) a /regular expression/?
+    static bool isRegExpFilter(const QString &filter)
+    {
+        return filter.startsWith(QL1C('/')) && filter.endsWith(QL1C('/'));
+    }
+
+    // Parse a rule and add it. Returns the rule number
+    int addRule(const QString &filter);
+
+    // Add an already parsed rule, as saved by saveRule(). Returns the rule number
+    int loadRule(QDataStream &in);
+    void saveRule(int rule, QDataStream &out) const;
+
+    bool match(int rule,
+               const QNetworkRequest &request,
+               const QString &encodedUrl,
+               const QString &encodedUrlLowerCase,
+               quint16 requestOptions) const;
+
+    RuleType type(int rule) const
+    {
+        return RuleType(m_rules.at(rule).type);
+    }
+
+    // This is just for debugging purposes
+    QString ruleString(int rule) const;
+
+    int count() const
+    {
+        return m_rules.count();
+    }
+
+    void clear();
+
+    // free the room reserved for more rules, once they are all added
+    void squeeze();
+
+private:
+    struct Rule
+    {
+        quint8 type;            // RuleType
+        quint8 patternFlags;    // AdBlockPattern flags
+        quint16 options;        // AdBlockOptions
+        int pattern;            // string number (in m_regExps, for RegExpRule)
+        int firstDomain;        // in m_domains
+        int domainCount;
+    };
+
+    // a string number, of an equal string already there or of the string appended
+    int intern(const QString &newString);
+
+    QStringRef string(int id) const
+    {
+        const StringSpan &span = m_strings.at(id);
+        return QStringRef(&m_stringData, span.position, span.length);
+    }
+
+    void addDomain(Rule &rule, const QString &domain);
+
+    // domain= option: is the rule about the page sending the request?
+    bool matchDomains(const Rule &rule, const QNetworkRequest &request) const;
+
+    QVector<Rule> m_rules;
+
+    struct StringSpan
+    {
+        int position;           // in m_stringData
+        int length;
+    };
+
+    // Every interned string, one after the other, and where each one is.
+    // Strings are found by their hash: no string is kept twice
+    QString m_stringData;
+    QVector<StringSpan> m_strings;
+    QMultiHash<uint, int> m_stringIds;
+
+    // string numbers of the domain= options (~domains are stored negative: -number - 1)
+    QVector<int> m_domains;
+
+    QVector<QRegExp> m_regExps;
+};
+
+#endif // ADBLOCKRULETABLE_H
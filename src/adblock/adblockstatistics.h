@@ -0,0 +1,79 @@
+/* ============================================================
+*
+* This file is a part of the rekonq project
+*
+* Copyright (C) 2012 by Andrea Diamantini <adjam7 at gmail dot com>
+*
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as
+* published by the Free Software Foundation; either version 2 of
+* the License or (at your option) version 3 or any later version
+* accepted by the membership of KDE e.V. (or its successor approved
+* by the membership of KDE e.V.), which shall act as a proxy
+* defined in Section 14 of version 3 of the license.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* ============================================================ */
+
+
+
+
+#ifndef ADBLOCKSTATISTICS_H
+#define ADBLOCKSTATISTICS_H
+
+
+// Qt Includes
+#include <QString>
+
+
+// What an adblock rule did, since the rule set it is in has been loaded
+struct AdBlockRuleStatistics
+{
+    enum RuleClass
+    {
+        HostRule,       // ||host^ rules, matched all together on the host
+        TextRule,       // plain text rules, matched all together by one automaton
+        PatternRule,    // indexed rules: wildcards, anchors, options...
+        RegExpRule,     // indexed /regular expression/ rules
+        RuleClassCount
+    };
+
+    QString rule;
+    RuleClass ruleClass;
+    bool isWhiteRule;
+    int hits;
+
+    // nanoseconds spent matching the rule: just regular expressions are timed
+    // one by one, see AdBlockRuleSet::matchTime() for the others
+    qint64 matchTime;
+};
+
+
+// What adblock did for a page, since it started loading
+struct AdBlockPageStatistics
+{
+    AdBlockPageStatistics()
+        : checkedRequests(0)
+        , blockedRequests(0)
+        , cachedDecisions(0)
+        , matchTime(0)
+    {
+    }
+
+    int checkedRequests;
+    int blockedRequests;
+    int cachedDecisions;    // requests decided by the AdBlockManager decision cache
+
+    // nanoseconds spent matching rules for the page requests
+    qint64 matchTime;
+};
+
+#endif // ADBLOCKSTATISTICS_H
@@ -0,0 +1,302 @@
+/* ============================================================
+*
+* This file is a part of the rekonq project
+*
+* Copyright (C) 2012 by Andrea Diamantini <adjam7 at gmail dot com>
+*
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as
+* published by the Free Software Foundation; either version 2 of
+* the License or (at your option) version 3 or any later version
+* accepted by the membership of KDE e.V. (or its successor approved
+* by the membership of KDE e.V.), which shall act as a proxy
+* defined in Section 14 of version 3 of the license.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* ============================================================ */
+
+
+// Self Includes
+#include "adblocktextmatcher.h"
+
+// Rekonq Includes
+#include "rekonq_defines.h"
+
+// Qt Includes
+#include <QHash>
+#include <QtAlgorithms>
+
+
+AdBlockTextMatcher::AdBlockTextMatcher()
+    : m_matchAll(-1)
+    , m_needsBuild(false)
+{
+}
+
+
+bool AdBlockTextMatcher::tryAddFilter(const QString &filter)
+{
+    if (!isTextMatchFilter(filter))
+        return false;
+
+    // work on lowercase text (to compare with the lowercase url), without wildcards
+    QString pattern = filter.toLower();
+    pattern.remove(QL1C('*'));
+
+    // an empty text is found in every url...
+    if (pattern.isEmpty() && m_matchAll < 0)
+        m_matchAll = m_patterns.count();
+
+    m_patterns << pattern;
+    m_hits << 0;
+
+    m_needsBuild = true;
+    return true;
+}
+
+
+bool AdBlockTextMatcher::isTextMatchFilter(const QString &filter)
+{
+    // We don't deal with options here
+    if (filter.contains(QL1C('$')))
+        return false;
+
+    // We don't deal with element matching
+    if (filter.contains(QL1S("##")))
+        return false;
+
+    // We don't deal with the begin-end matching
+    if (filter.startsWith(QL1C('|')) || filter.endsWith(QL1C('|')))
+        return false;
+
+    // We only handle * at the beginning or the end
+    int starPosition = filter.indexOf(QL1C('*'));
+    while (starPosition >= 0)
+    {
+        if (starPosition != 0 && starPosition != (filter.length() - 1))
+            return false;
+        starPosition = filter.indexOf(QL1C('*'), starPosition + 1);
+    }
+    return true;
+}
+
+
+void AdBlockTextMatcher::build()
+{
+    if (!m_needsBuild)
+        return;
+    m_needsBuild = false;
+
+    m_nodes.clear();
+    m_edges.clear();
+
+    // 1. Build the trie. Children are stored in a (node, char) keyed hash
+    QHash<quint64, int> children;
+    QVector<int> patternNodes(1, -1);
+
+    for (int p = 0; p < m_patterns.count(); ++p)
+    {
+        const QString &pattern = m_patterns.at(p);
+        if (pattern.isEmpty())
+            continue;
+
+        int node = 0;
+        for (int i = 0; i < pattern.length(); ++i)
+        {
+            const quint64 key = (quint64(node) << 16) | pattern.at(i).unicode();
+            QHash<quint64, int>::const_iterator it = children.constFind(key);
+            if (it != children.constEnd())
+            {
+                node = it.value();
+            }
+            else
+            {
+                const int newNode = patternNodes.count();
+                children.insert(key, newNode);
+                patternNodes << -1;
+                node = newNode;
+            }
+        }
+
+        // on duplicates, the first one wins
+        if (patternNodes.at(node) < 0)
+            patternNodes[node] = p;
+    }
+
+    // 2. Flatten the edges: sorting the keys groups them by node, and by char inside a node
+    QList<quint64> keys = children.keys();
+    qSort(keys);
+
+    m_nodes.resize(patternNodes.count());
+    for (int i = 0; i < m_nodes.count(); ++i)
+    {
+        Node &node = m_nodes[i];
+        node.firstEdge = 0;
+        node.edgeCount = 0;
+        node.fail = 0;
+        node.pattern = patternNodes.at(i);
+        node.output = -1;
+    }
+
+    m_edges.reserve(keys.count());
+    Q_FOREACH(const quint64 key, keys)
+    {
+        const int parent = int(key >> 16);
+        Edge edge;
+        edge.c = ushort(key & 0xFFFF);
+        edge.target = children.value(key);
+
+        Node &node = m_nodes[parent];
+        if (node.edgeCount == 0)
+            node.firstEdge = m_edges.count();
+        node.edgeCount++;
+
+        m_edges << edge;
+    }
+
+    // 3. Compute fail links and outputs, visiting the trie breadth first
+    QVector<int> queue;
+    queue.reserve(m_nodes.count());
+    queue << 0;
+
+    for (int head = 0; head < queue.count(); ++head)
+    {
+        const int parent = queue.at(head);
+        const int firstEdge = m_nodes.at(parent).firstEdge;
+        const int lastEdge = firstEdge + m_nodes.at(parent).edgeCount;
+
+        for (int e = firstEdge; e < lastEdge; ++e)
+        {
+            const ushort c = m_edges.at(e).c;
+            const int child = m_edges.at(e).target;
+
+            const int fail = (parent == 0) ? 0 : nextState(m_nodes.at(parent).fail, c);
+
+            Node &node = m_nodes[child];
+            node.fail = fail;
+            node.output = (node.pattern >= 0) ? child : m_nodes.at(fail).output;
+
+            queue << child;
+        }
+    }
+}
+
+
+bool AdBlockTextMatcher::match(const QString &encodedUrlLowerCase) const
+{
+    Q_ASSERT(!m_needsBuild);
+
+    if (m_matchAll >= 0)
+    {
+        m_hits[m_matchAll]++;
+        return true;
+    }
+
+    if (m_nodes.isEmpty())
+        return false;
+
+    const QChar *data = encodedUrlLowerCase.constData();
+    const int length = encodedUrlLowerCase.length();
+
+    int state = 0;
+    for (int i = 0; i < length; ++i)
+    {
+        state = nextState(state, data[i].unicode());
+        const int output = m_nodes.at(state).output;
+        if (output >= 0)
+        {
+            m_hits[m_nodes.at(output).pattern]++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+QStringList AdBlockTextMatcher::matchingRules(const QString &encodedUrlLowerCase) const
+{
+    QStringList rules;
+
+    if (m_nodes.isEmpty())
+        return rules;
+
+    const QChar *data = encodedUrlLowerCase.constData();
+    const int length = encodedUrlLowerCase.length();
+
+    int state = 0;
+    for (int i = 0; i < length; ++i)
+    {
+        state = nextState(state, data[i].unicode());
+
+        int node = m_nodes.at(state).output;
+        while (node >= 0)
+        {
+            const QString &rule = m_patterns.at(m_nodes.at(node).pattern);
+            if (!rules.contains(rule))
+                rules << rule;
+            node = m_nodes.at(m_nodes.at(node).fail).output;
+        }
+    }
+
+    return rules;
+}
+
+
+void AdBlockTextMatcher::clear()
+{
+    m_patterns.clear();
+    m_nodes.clear();
+    m_edges.clear();
+    m_hits.clear();
+    m_matchAll = -1;
+    m_needsBuild = false;
+}
+
+
+int AdBlockTextMatcher::nextState(int state, ushort c) const
+{
+    while (true)
+    {
+        const int next = transition(state, c);
+        if (next >= 0)
+            return next;
+
+        if (state == 0)
+            return 0;
+
+        state = m_nodes.at(state).fail;
+    }
+}
+
+
+int AdBlockTextMatcher::transition(int state, ushort c) const
+{
+    const Node &node = m_nodes.at(state);
+
+    // binary search between the (sorted) edges of the node
+    int low = node.firstEdge;
+    int high = node.firstEdge + node.edgeCount - 1;
+    while (low <= high)
+    {
+        const int middle = (low + high) / 2;
+        const ushort middleChar = m_edges.at(middle).c;
+        if (middleChar == c)
+            return m_edges.at(middle).target;
+
+        if (middleChar < c)
+            low = middle + 1;
+        else
+            high = middle - 1;
+    }
+
+    return -1;
+}
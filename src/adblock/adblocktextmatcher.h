@@ -0,0 +1,111 @@
+/* ============================================================
+*
+* This file is a part of the rekonq project
+*
+* Copyright (C) 2012 by Andrea Diamantini <adjam7 at gmail dot com>
+*
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as
+* published by the Free Software Foundation; either version 2 of
+* the License or (at your option) version 3 or any later version
+* accepted by the membership of KDE e.V. (or its successor approved
+* by the membership of KDE e.V.), which shall act as a proxy
+* defined in Section 14 of version 3 of the license.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* ============================================================ */
+
+
+#ifndef ADBLOCKTEXTMATCHER_H
+#define ADBLOCKTEXTMATCHER_H
+
+
+// Qt Includes
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+
+// All the plain text rules compiled in one Aho-Corasick automaton,
+// so that a single pass over the url finds every rule matching it.
+class AdBlockTextMatcher
+{
+public:
+    AdBlockTextMatcher();
+
+    // Try to add an adblock filter to this text matcher.
+    // If the filter is not a plain text one, the filter is not added
+    // and the method return false;
+    bool tryAddFilter(const QString &filter);
+
+    // Plain text filters: no options, no anchors, and wildcards just at the beginning or the end
+    static bool isTextMatchFilter(const QString &filter);
+
+    // (Re)compile the automaton: call this after adding filters
+    void build();
+
+    bool match(const QString &encodedUrlLowerCase) const;
+
+    // Every text rule found in the url. Mainly for debugging purposes
+    QStringList matchingRules(const QString &encodedUrlLowerCase) const;
+
+    // number of filters added
+    int count() const
+    {
+        return m_patterns.count();
+    }
+
+    // The (lowercase, without wildcards) text of a filter, and how many
+    // times it matched. Just the first of duplicated filters matches.
+    const QString &pattern(int filter) const
+    {
+        return m_patterns.at(filter);
+    }
+
+    int hits(int filter) const
+    {
+        return m_hits.at(filter);
+    }
+
+    void clear();
+
+private:
+    struct Node
+    {
+        int firstEdge;
+        int edgeCount;
+        int fail;
+        int pattern;    // pattern ending here, or -1
+        int output;     // nearest node in the fail chain with a pattern (this included), or -1
+    };
+
+    struct Edge
+    {
+        ushort c;
+        int target;
+    };
+
+    int nextState(int state, ushort c) const;
+    int transition(int state, ushort c) const;
+
+    QStringList m_patterns;
+    QVector<Node> m_nodes;
+    QVector<Edge> m_edges;
+
+    // NOTE: counted on match, so a matcher is not meant to be shared between threads
+    mutable QVector<int> m_hits;
+
+    // the first empty pattern (found in every url), or -1
+    int m_matchAll;
+    bool m_needsBuild;
+};
+
+#endif // ADBLOCKTEXTMATCHER_H
@@ -35,6 +35,7 @@
 #include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QPushButton>
+#include <QTreeWidgetItem>
 
 
 BlockedElementsWidget::BlockedElementsWidget(QObject *manager, QWidget *parent)
@@ -86,6 +87,68 @@ void BlockedElementsWidget::setHidedElements(int n)
 }
 
 
+static QString ruleClassName(AdBlockRuleStatistics::RuleClass ruleClass)
+{
+    switch (ruleClass)
+    {
+    case AdBlockRuleStatistics::HostRule:
+        return i18nc("adblock rule kind", "Host");
+    case AdBlockRuleStatistics::TextRule:
+        return i18nc("adblock rule kind", "Text");
+    case AdBlockRuleStatistics::PatternRule:
+        return i18nc("adblock rule kind", "Pattern");
+    case AdBlockRuleStatistics::RegExpRule:
+        return i18nc("adblock rule kind", "Regular expression");
+    default:
+        return QString();
+    }
+}
+
+
+void BlockedElementsWidget::setRuleStatistics(const QList<AdBlockRuleStatistics> &ruleStatistics,
+                                              const QList<qint64> &classMatchTimes,
+                                              const AdBlockPageStatistics &pageStatistics)
+{
+    QStringList classTimes;
+    for (int i = 0; i < classMatchTimes.count(); ++i)
+    {
+        const AdBlockRuleStatistics::RuleClass ruleClass = AdBlockRuleStatistics::RuleClass(i);
+        classTimes << i18nc("adblock rule kind: match time", "%1: %2 ms",
+                            ruleClassName(ruleClass),
+                            QString::number(classMatchTimes.at(i) / 1000000.0, 'f', 1));
+    }
+
+    statisticsLabel->setText(i18n("This page: %1 requests checked (%2 from cache), %3 blocked, %4 ms matching rules.",
+                                  pageStatistics.checkedRequests,
+                                  pageStatistics.cachedDecisions,
+                                  pageStatistics.blockedRequests,
+                                  QString::number(pageStatistics.matchTime / 1000000.0, 'f', 1))
+                             + QL1C('\n')
+                             + i18n("All pages: %1.", classTimes.join(QL1S(", "))));
+
+    // Items are sorted by (numeric) data: hits and times sort right
+    rulesTreeWidget->setSortingEnabled(false);
+
+    QList<QTreeWidgetItem *> items;
+    Q_FOREACH(const AdBlockRuleStatistics & rule, ruleStatistics)
+    {
+        QTreeWidgetItem *item = new QTreeWidgetItem;
+        item->setText(0, rule.isWhiteRule ? QL1S("@@") + rule.rule : rule.rule);
+        item->setText(1, ruleClassName(rule.ruleClass));
+        item->setData(2, Qt::DisplayRole, rule.hits);
+        if (rule.ruleClass == AdBlockRuleStatistics::RegExpRule)
+            item->setData(3, Qt::DisplayRole, qlonglong(rule.matchTime / 1000));
+        items << item;
+    }
+    rulesTreeWidget->addTopLevelItems(items);
+
+    // most used rules first (dead ones last): headers sort by the other columns
+    rulesTreeWidget->setSortingEnabled(true);
+    rulesTreeWidget->sortItems(2, Qt::DescendingOrder);
+    rulesTreeWidget->resizeColumnToContents(1);
+}
+
+
 void BlockedElementsWidget::unblockElement()
 {
     QPushButton *buttonClicked = qobject_cast<QPushButton *>(sender());
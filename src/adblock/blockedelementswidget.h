@@ -31,10 +31,14 @@
 // Rekonq Includes
 #include "rekonq_defines.h"
 
+// Local Includes
+#include "adblockstatistics.h"
+
 // Ui Includes
 #include "ui_blocked_elements.h"
 
 // Qt Includes
+#include <QList>
 #include <QWidget>
 
 
@@ -48,6 +52,11 @@ public:
     void setBlockedElements(const QStringList &);
     void setHidedElements(int);
 
+    // per rule hits and times, rule class times (indexed by RuleClass) and page totals
+    void setRuleStatistics(const QList<AdBlockRuleStatistics> &ruleStatistics,
+                           const QList<qint64> &classMatchTimes,
+                           const AdBlockPageStatistics &pageStatistics);
+
     bool pageNeedsReload()
     {
         return _reloadPage;
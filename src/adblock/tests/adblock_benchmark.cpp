@@ -0,0 +1,320 @@
+/* ============================================================
+*
+* This file is a part of the rekonq project
+*
+* Copyright (C) 2012 by Andrea Diamantini <adjam7 at gmail dot com>
+*
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as
+* published by the Free Software Foundation; either version 2 of
+* the License or (at your option) version 3 or any later version
+* accepted by the membership of KDE e.V. (or its successor approved
+* by the membership of KDE e.V.), which shall act as a proxy
+* defined in Section 14 of version 3 of the license.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* ============================================================ */
+
+
+#include <qtest_kde.h>
+
+#include "adblockmanager.h"
+#include "adblockoptions.h"
+#include "adblockruleset.h"
+
+// KDE Includes
+#include <KConfig>
+#include <KConfigGroup>
+#include <KStandardDirs>
+#include <KTempDir>
+
+// Qt Includes
+#include <QElapsedTimer>
+#include <QFile>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QTextStream>
+
+
+// Benchmark the adblock engine, loading rules files and replaying a corpus of requests.
+//
+// It runs on the sample files in this directory, unless told otherwise:
+// REKONQ_ADBLOCK_RULES    rules files (eg: real subscriptions), separated by ':'
+// REKONQ_ADBLOCK_URLS     requests corpus, one "url referrer" per line
+//
+// A corpus shorter than minRequests is replayed until it is that long: every other
+// time with a query string making its urls new ones, as they are the other times.
+//
+// Requests are replayed through AdBlockManager::block(), decision cache included,
+// and through AdBlockRuleSet::decision(), to time the rules alone.
+class AdBlockBenchmark : public QObject
+{
+    Q_OBJECT
+
+public Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+private Q_SLOTS:
+    void loadRules();
+    void loadCachedRules();
+    void decideRequests();
+    void blockRequests();
+
+private:
+    void readRequests(const QString &urlsFilePath);
+    bool isBlocked(const QNetworkRequest &request) const;
+
+    QStringList rulesFiles;
+    QList<QNetworkRequest> requests;
+
+    KTempDir cacheDir;
+    AdBlockRuleSet *ruleSet;
+};
+
+
+static const int minRequests = 50000;
+
+
+// Resident memory of this process, in kB (on Linux)
+static long residentMemory()
+{
+    QFile status(QL1S("/proc/self/status"));
+    if (!status.open(QFile::ReadOnly | QFile::Text))
+        return -1;
+
+    QTextStream in(&status);
+    while (!in.atEnd())
+    {
+        const QString line = in.readLine();
+        if (line.startsWith(QL1S("VmRSS:")))
+            return line.mid(6).remove(QL1S("kB")).trimmed().toLong();
+    }
+    return -1;
+}
+
+
+// -------------------------------------------
+
+void AdBlockBenchmark::initTestCase()
+{
+    const QString rulesEnv = QString::fromLocal8Bit(qgetenv("REKONQ_ADBLOCK_RULES"));
+    rulesFiles = rulesEnv.isEmpty()
+                 ? QStringList(QL1S(ADBLOCK_TESTS_DIR "/RULES"))
+                 : rulesEnv.split(QL1C(':'), QString::SkipEmptyParts);
+
+    QString urlsFilePath = QString::fromLocal8Bit(qgetenv("REKONQ_ADBLOCK_URLS"));
+    if (urlsFilePath.isEmpty())
+        urlsFilePath = QL1S(ADBLOCK_TESTS_DIR "/URLS");
+
+    readRequests(urlsFilePath);
+    QVERIFY(!requests.isEmpty());
+
+    ruleSet = 0;
+}
+
+
+void AdBlockBenchmark::cleanupTestCase()
+{
+    delete ruleSet;
+}
+
+
+// -------------------------------------------
+
+void AdBlockBenchmark::loadRules()
+{
+    const long memoryBefore = residentMemory();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // no cache yet: every rule is parsed
+    QBENCHMARK_ONCE
+    {
+        delete ruleSet;
+        ruleSet = AdBlockRuleSet::loadFiles(rulesFiles, cacheDir.name());
+    }
+
+    qDebug() << "Rules parsed in" << timer.elapsed() << "ms,"
+             << "resident memory grown by" << (residentMemory() - memoryBefore) << "kB";
+
+    qDebug() << "Host rules:" << ruleSet->hostRulesCount()
+             << "Text rules:" << ruleSet->textRulesCount()
+             << "Indexed text rules:" << ruleSet->indexedRulesCount(AdBlockRuleTable::TextRule)
+             << "Pattern rules:" << ruleSet->indexedRulesCount(AdBlockRuleTable::PatternRule)
+             << "RegExp rules:" << ruleSet->indexedRulesCount(AdBlockRuleTable::RegExpRule)
+             << "Null rules:" << ruleSet->indexedRulesCount(AdBlockRuleTable::NullRule)
+             << "Hide rules:" << ruleSet->hideRulesCount();
+}
+
+
+void AdBlockBenchmark::loadCachedRules()
+{
+    QVERIFY(ruleSet);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // the same, from the binary caches written by loadRules
+    QBENCHMARK_ONCE
+    {
+        delete ruleSet;
+        ruleSet = AdBlockRuleSet::loadFiles(rulesFiles, cacheDir.name());
+    }
+
+    qDebug() << "Rules loaded from cache in" << timer.elapsed() << "ms,"
+             << "resident memory:" << residentMemory() << "kB";
+}
+
+
+void AdBlockBenchmark::decideRequests()
+{
+    QVERIFY(ruleSet);
+
+    int blockedRequests = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    Q_FOREACH(const QNetworkRequest & request, requests)
+    {
+        if (isBlocked(request))
+            blockedRequests++;
+    }
+
+    const qint64 elapsed = timer.nsecsElapsed();
+
+    qDebug() << requests.count() << "requests," << blockedRequests << "blocked,"
+             << elapsed / requests.count() << "ns per request, with no decision cache";
+    qDebug() << "Match time (ns) by rule class: host" << ruleSet->matchTime(AdBlockRuleStatistics::HostRule)
+             << "text" << ruleSet->matchTime(AdBlockRuleStatistics::TextRule)
+             << "pattern" << ruleSet->matchTime(AdBlockRuleStatistics::PatternRule)
+             << "regexp" << ruleSet->matchTime(AdBlockRuleStatistics::RegExpRule);
+
+    QBENCHMARK
+    {
+        Q_FOREACH(const QNetworkRequest & request, requests)
+        {
+            isBlocked(request);
+        }
+    }
+}
+
+
+void AdBlockBenchmark::blockRequests()
+{
+    // the manager settings and (all the) rules, where it looks for them
+    KConfig adblockConfig(KStandardDirs::locateLocal("appdata", QL1S("adblockrc")), KConfig::SimpleConfig);
+    adblockConfig.group("Settings").writeEntry("adBlockEnabled", true);
+    adblockConfig.sync();
+
+    QFile localRulesFile(KStandardDirs::locateLocal("appdata", QL1S("adblockrules_local")));
+    QVERIFY(localRulesFile.open(QFile::WriteOnly | QFile::Truncate));
+    Q_FOREACH(const QString & rulesFilePath, rulesFiles)
+    {
+        QFile rulesFile(rulesFilePath);
+        QVERIFY(rulesFile.open(QFile::ReadOnly));
+        localRulesFile.write(rulesFile.readAll());
+        localRulesFile.write("\n");
+    }
+    localRulesFile.close();
+
+    // rules are loaded in a worker thread
+    AdBlockManager manager;
+    for (int i = 0; manager.ruleStatistics().isEmpty() && i < 1200; ++i)
+        QTest::qWait(50);
+    QVERIFY(!manager.ruleStatistics().isEmpty());
+
+    int blockedRequests = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // no page: blocked requests are not collapsed, but everything else is done
+    Q_FOREACH(const QNetworkRequest & request, requests)
+    {
+        QNetworkReply *reply = manager.block(request, 0);
+        if (reply)
+            blockedRequests++;
+        delete reply;
+    }
+
+    const qint64 elapsed = timer.nsecsElapsed();
+
+    qDebug() << requests.count() << "requests," << blockedRequests << "blocked,"
+             << elapsed / requests.count() << "ns per request, through block()";
+    qDebug() << "Decision cache hits:" << manager.decisionCacheHits()
+             << "misses:" << manager.decisionCacheMisses();
+
+    QBENCHMARK
+    {
+        Q_FOREACH(const QNetworkRequest & request, requests)
+        {
+            delete manager.block(request, 0);
+        }
+    }
+}
+
+
+// -------------------------------------------
+
+void AdBlockBenchmark::readRequests(const QString &urlsFilePath)
+{
+    QFile urlsFile(urlsFilePath);
+    QVERIFY(urlsFile.open(QFile::ReadOnly | QFile::Text));
+
+    QList<QStringList> lines;
+
+    QTextStream in(&urlsFile);
+    while (!in.atEnd())
+    {
+        const QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith(QL1C('#')))
+            continue;
+
+        lines << line.split(QL1C(' '), QString::SkipEmptyParts);
+    }
+
+    if (lines.isEmpty())
+        return;
+
+    for (int round = 0; round == 0 || requests.count() < minRequests; ++round)
+    {
+        Q_FOREACH(const QStringList & fields, lines)
+        {
+            QByteArray url = fields.at(0).toUtf8();
+            if (round % 2)
+                url += (url.contains('?') ? "&round=" : "?round=") + QByteArray::number(round);
+
+            QNetworkRequest request(QUrl::fromEncoded(url));
+            if (fields.count() > 1)
+                request.setRawHeader("Referer", fields.at(1).toUtf8());
+            requests << request;
+        }
+    }
+}
+
+
+bool AdBlockBenchmark::isBlocked(const QNetworkRequest &request) const
+{
+    const QString urlString = request.url().toString();
+    const quint16 requestOptions = AdBlockOptions::requestOptions(request);
+
+    return ruleSet->decision(request, urlString, urlString.toLower(), request.url().host(), requestOptions)
+           != AdBlockRuleSet::NotBlocked;
+}
+
+
+// -------------------------------------------
+
+QTEST_KDEMAIN(AdBlockBenchmark, NoGUI)
+#include "adblock_benchmark.moc"
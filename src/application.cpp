@@ -40,6 +40,7 @@
 #include "adblockmanager.h"
 #include "bookmarkmanager.h"
 #include "downloadmanager.h"
+#include "filewriter.h"
 #include "historymanager.h"
 #include "iconmanager.h"
 #include "mainview.h"
@@ -168,6 +169,14 @@ Application::~Application()
         m_downloadManager.clear();
     }
 
+    // last one: it writes what the others saved
+    if (!m_fileWriter.isNull())
+    {
+        kDebug() << "deleting file writer";
+        delete m_fileWriter.data();
+        m_fileWriter.clear();
+    }
+
     kDebug() << "Bye bye...";
 }
 
@@ -436,6 +445,16 @@ DownloadManager *Application::downloadManager()
 }
 
 
+FileWriter *Application::fileWriter()
+{
+    if (m_fileWriter.isNull())
+    {
+        m_fileWriter = new FileWriter(instance());
+    }
+    return m_fileWriter.data();
+}
+
+
 UserAgentManager *Application::userAgentManager()
 {
     if (m_userAgentManager.isNull())
@@ -652,6 +671,7 @@ void Application::updateConfiguration()
 
     // ====== load Settings on main classes
     historyManager()->loadSettings();
+    fileWriter()->setSyncInterval(ReKonfig::fileSyncInterval());
 
     defaultSettings = 0;
 
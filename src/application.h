@@ -50,6 +50,7 @@ class QWebHistory;
 class AdBlockManager;
 class BookmarkManager;
 class DownloadManager;
+class FileWriter;
 class HistoryManager;
 class IconManager;
 class MainWindow;
@@ -93,6 +94,7 @@ public:
     OpenSearchManager *opensearchManager();
     IconManager *iconManager();
     DownloadManager *downloadManager();
+    FileWriter *fileWriter();
     UserAgentManager *userAgentManager();
     SyncManager *syncManager();
 
@@ -144,6 +146,7 @@ private:
     QWeakPointer<OpenSearchManager> m_opensearchManager;
     QWeakPointer<IconManager> m_iconManager;
     QWeakPointer<DownloadManager> m_downloadManager;
+    QWeakPointer<FileWriter> m_fileWriter;
     QWeakPointer<UserAgentManager> m_userAgentManager;
     QWeakPointer<SyncManager> m_syncManager;
 
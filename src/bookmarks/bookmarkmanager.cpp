@@ -157,10 +157,26 @@ QList<KBookmark> BookmarkManager::find(const QString &text)
 {
     QList<KBookmark> list;
 
+    const QStringList words = text.split(' ');
     KBookmarkGroup root = rootGroup();
     if (!root.isNull())
         for (KBookmark bookmark = root.first(); !bookmark.isNull(); bookmark = root.next(bookmark))
-            find(&list, bookmark, text);
+            find(&list, bookmark, words);
+
+    return list;
+}
+
+
+QList<KBookmark> BookmarkManager::find(const QString &text, const QList<KBookmark> &bookmarks)
+{
+    QList<KBookmark> list;
+
+    const QStringList words = text.split(' ');
+    Q_FOREACH(const KBookmark & bookmark, bookmarks)
+    {
+        if (matches(bookmark, words))
+            list << bookmark;
+    }
 
     return list;
 }
@@ -250,33 +266,36 @@ void BookmarkManager::slotPanelChanged()
 }
 
 
-void BookmarkManager::find(QList<KBookmark> *list, const KBookmark &bookmark, const QString &text)
+void BookmarkManager::find(QList<KBookmark> *list, const KBookmark &bookmark, const QStringList &words)
 {
     if (bookmark.isGroup())
     {
         KBookmarkGroup group = bookmark.toGroup();
         for (KBookmark bm = group.first(); !bm.isNull(); bm = group.next(bm))
-            find(list, bm, text);
+            find(list, bm, words);
     }
     else
     {
-        QStringList words = text.split(' ');
-        bool matches = true;
-        Q_FOREACH(const QString & word, words)
-        {
-            if (!bookmark.url().url().contains(word, Qt::CaseInsensitive)
-                    && !bookmark.fullText().contains(word, Qt::CaseInsensitive))
-            {
-                matches = false;
-                break;
-            }
-        }
-        if (matches)
+        if (matches(bookmark, words))
             *list << bookmark;
     }
 }
 
 
+bool BookmarkManager::matches(const KBookmark &bookmark, const QStringList &words)
+{
+    const QString url = bookmark.url().url();
+    const QString text = bookmark.fullText();
+    Q_FOREACH(const QString & word, words)
+    {
+        if (!url.contains(word, Qt::CaseInsensitive)
+                && !text.contains(word, Qt::CaseInsensitive))
+            return false;
+    }
+    return true;
+}
+
+
 KBookmark BookmarkManager::bookmarkForUrl(const KBookmark &bookmark, const KUrl &url)
 {
     KBookmark found;
@@ -39,6 +39,7 @@
 
 // Qt Includes
 #include <QObject>
+#include <QStringList>
 
 // Forward Declarations
 class BookmarksPanel;
@@ -120,6 +121,9 @@ public:
 
     QList<KBookmark> find(const QString &text);
 
+    // The ones of bookmarks matching text: those found for a shorter one, eg
+    QList<KBookmark> find(const QString &text, const QList<KBookmark> &bookmarks);
+
     KBookmark bookmarkForUrl(const KUrl &url);
 
     KBookmark findByAddress(const QString &);
@@ -157,7 +161,8 @@ Q_SIGNALS:
     void bookmarksUpdated();
 
 private:
-    void find(QList<KBookmark> *list, const KBookmark &bookmark, const QString &text);
+    void find(QList<KBookmark> *list, const KBookmark &bookmark, const QStringList &words);
+    static bool matches(const KBookmark &bookmark, const QStringList &words);
     KBookmark bookmarkForUrl(const KBookmark &bookmark, const KUrl &url);
     void copyBookmarkGroup(const KBookmarkGroup &groupToCopy, KBookmarkGroup destGroup);
 
@@ -32,6 +32,10 @@
 // Auto Includes
 #include "rekonq.h"
 
+// Local Includes
+#include "application.h"
+#include "filewriter.h"
+
 // KDE Includes
 #include <KStandardDirs>
 #include <KToolInvocation>
@@ -70,16 +74,8 @@ DownloadManager::~DownloadManager()
     if (!m_needToSave)
         return;
 
-    QString downloadFilePath = KStandardDirs::locateLocal("appdata" , "downloads");
-    QFile downloadFile(downloadFilePath);
-
-    if (!downloadFile.open(QFile::WriteOnly))
-    {
-        kDebug() << "Unable to open download file (WRITE mode)..";
-        return;
-    }
-
-    QDataStream out(&downloadFile);
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
     Q_FOREACH(DownloadItem * item, m_downloadList)
     {
         out << item->originUrl();
@@ -87,7 +83,7 @@ DownloadManager::~DownloadManager()
         out << item->dateTime();
     }
 
-    downloadFile.close();
+    rApp->fileWriter()->replaceFile(KStandardDirs::locateLocal("appdata" , "downloads"), data);
 }
 
 
@@ -124,18 +120,13 @@ DownloadItem* DownloadManager::addDownload(KIO::CopyJob *job)
 
     KIO::CopyJob *cJob = qobject_cast<KIO::CopyJob *>(job);
 
-    QString downloadFilePath = KStandardDirs::locateLocal("appdata" , "downloads");
-    QFile downloadFile(downloadFilePath);
-    if (!downloadFile.open(QFile::WriteOnly | QFile::Append))
-    {
-        kDebug() << "Unable to open download file (WRITE mode)..";
-        return 0;
-    }
-    QDataStream out(&downloadFile);
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
     out << cJob->srcUrls().at(0).url();
     out << cJob->destUrl().url();
     out << QDateTime::currentDateTime();
-    downloadFile.close();
+    rApp->fileWriter()->appendToFile(KStandardDirs::locateLocal("appdata" , "downloads"), data);
+
     DownloadItem *item = new DownloadItem(job, QDateTime::currentDateTime(), this);
     m_downloadList.append(item);
     emit newDownloadAdded(item);
@@ -149,18 +140,13 @@ DownloadItem* DownloadManager::addKGetDownload(const QString &srcUrl, const QStr
     if (globalSettings->testAttribute(QWebSettings::PrivateBrowsingEnabled))
         return 0;
 
-    QString downloadFilePath = KStandardDirs::locateLocal("appdata" , "downloads");
-    QFile downloadFile(downloadFilePath);
-    if (!downloadFile.open(QFile::WriteOnly | QFile::Append))
-    {
-        kDebug() << "Unable to open download file (WRITE mode)..";
-        return 0;
-    }
-    QDataStream out(&downloadFile);
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
     out << srcUrl;
     out << destUrl;
     out << QDateTime::currentDateTime();
-    downloadFile.close();
+    rApp->fileWriter()->appendToFile(KStandardDirs::locateLocal("appdata" , "downloads"), data);
+
     DownloadItem *item = new DownloadItem(srcUrl, destUrl, QDateTime::currentDateTime(), this);
     item->setIsKGetDownload();
     m_downloadList.append(item);
@@ -172,9 +158,13 @@ DownloadItem* DownloadManager::addKGetDownload(const QString &srcUrl, const QStr
 bool DownloadManager::clearDownloadsHistory()
 {
     m_downloadList.clear();
+    m_needToSave = false;
+
+    // removed after the pending appends: wait for it, to tell how it went
     QString downloadFilePath = KStandardDirs::locateLocal("appdata" , "downloads");
-    QFile downloadFile(downloadFilePath);
-    return downloadFile.remove();
+    rApp->fileWriter()->removeFile(downloadFilePath);
+    rApp->fileWriter()->flush(downloadFilePath);
+    return !QFile::exists(downloadFilePath);
 }
 
 
@@ -0,0 +1,313 @@
+/* ============================================================
+*
+* This file is a part of the rekonq project
+*
+* Copyright (C) 2012 by Andrea Diamantini <adjam7 at gmail dot com>
+*
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as
+* published by the Free Software Foundation; either version 2 of
+* the License or (at your option) version 3 or any later version
+* accepted by the membership of KDE e.V. (or its successor approved
+* by the membership of KDE e.V.), which shall act as a proxy
+* defined in Section 14 of version 3 of the license.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* ============================================================ */
+
+
+
+
+// Self Includes
+#include "filewriter.h"
+#include "filewriter.moc"
+
+// KDE Includes
+#include <KSaveFile>
+
+// Qt Includes
+#include <QFile>
+#include <QTimer>
+#include <QtConcurrentRun>
+
+#include <unistd.h>
+
+
+// appended data is synced at most every 5 seconds, by default
+static const int defaultSyncInterval = 5000;
+
+// writes slower than this are reported (ns)
+static const qint64 slowWriteTime = Q_INT64_C(500000000);
+
+
+static bool syncFile(QFile &file)
+{
+    return file.flush() && fsync(file.handle()) == 0;
+}
+
+
+FileWriter::FileWriter(QObject *parent)
+    : QObject(parent)
+    , m_syncInterval(defaultSyncInterval)
+    , m_syncTimer(new QTimer(this))
+{
+    m_syncTimer->setSingleShot(true);
+    connect(m_syncTimer, SIGNAL(timeout()), this, SLOT(syncFiles()));
+    connect(&m_batchWatcher, SIGNAL(finished()), this, SLOT(batchFinished()));
+
+    m_lastSync.start();
+}
+
+
+FileWriter::~FileWriter()
+{
+    m_syncTimer->stop();
+    flush();
+
+    // the last appended data, too
+    if (!m_unsyncedFiles.isEmpty())
+    {
+        m_lastSync.invalidate();
+        startBatch();
+        m_batchWatcher.waitForFinished();
+        batchFinished();
+    }
+}
+
+
+void FileWriter::replaceFile(const QString &filePath, const QByteArray &data)
+{
+    addJob(ReplaceJob, filePath, data);
+}
+
+
+void FileWriter::appendToFile(const QString &filePath, const QByteArray &data)
+{
+    if (data.isEmpty())
+        return;
+
+    addJob(AppendJob, filePath, data);
+}
+
+
+void FileWriter::removeFile(const QString &filePath)
+{
+    addJob(RemoveJob, filePath);
+}
+
+
+void FileWriter::flush(const QString &filePath)
+{
+    if (!filePath.isEmpty() && !hasPendingJobs(filePath))
+        return;
+
+    while (!m_runningJobs.isEmpty() || !m_jobs.isEmpty())
+    {
+        startBatch();
+        m_batchWatcher.waitForFinished();
+        batchFinished();
+    }
+}
+
+
+void FileWriter::setSyncInterval(int msecs)
+{
+    m_syncInterval = qMax(0, msecs);
+}
+
+
+void FileWriter::addJob(JobType type, const QString &filePath, const QByteArray &data)
+{
+    // what was still to be written there is lost anyway
+    if (type == ReplaceJob || type == RemoveJob)
+    {
+        QList<Job>::iterator it = m_jobs.begin();
+        while (it != m_jobs.end())
+        {
+            if (it->filePath == filePath)
+                it = m_jobs.erase(it);
+            else
+                ++it;
+        }
+        m_unsyncedFiles.remove(filePath);
+    }
+
+    Job job;
+    job.type = type;
+    job.filePath = filePath;
+    job.data = data;
+    m_jobs << job;
+
+    startBatch();
+}
+
+
+void FileWriter::startBatch()
+{
+    if (!m_runningJobs.isEmpty())
+        return;
+
+    const bool sync = !m_lastSync.isValid() || m_lastSync.elapsed() >= m_syncInterval;
+    if (sync)
+    {
+        Q_FOREACH(const QString & filePath, m_unsyncedFiles)
+        {
+            Job job;
+            job.type = SyncJob;
+            job.filePath = filePath;
+            m_jobs << job;
+        }
+        m_unsyncedFiles.clear();
+        m_lastSync.start();
+    }
+
+    if (m_jobs.isEmpty())
+        return;
+
+    m_runningJobs = m_jobs;
+    m_jobs.clear();
+
+    m_batchWatcher.setFuture(QtConcurrent::run(FileWriter::runBatch, m_runningJobs, sync));
+}
+
+
+void FileWriter::batchFinished()
+{
+    // a finished() of a batch flush() already waited for
+    if (m_runningJobs.isEmpty() || !m_batchWatcher.isFinished())
+        return;
+
+    m_runningJobs.clear();
+
+    const QList<JobResult> results = m_batchWatcher.result();
+    Q_FOREACH(const JobResult & result, results)
+    {
+        if (result.time > slowWriteTime)
+            kDebug() << "Slow write of" << result.filePath << ":" << result.bytes << "bytes in" << result.time / 1000000 << "ms";
+
+        if (!result.ok)
+            kDebug() << "Unable to write file" << result.filePath;
+
+        if (result.type == SyncJob)
+            continue;
+
+        if (result.type == AppendJob && result.ok && !result.synced)
+            m_unsyncedFiles.insert(result.filePath);
+
+        emit fileWritten(result.filePath, result.ok);
+    }
+
+    if (!m_unsyncedFiles.isEmpty() && !m_syncTimer->isActive())
+    {
+        const qint64 remaining = m_syncInterval - m_lastSync.elapsed();
+        m_syncTimer->start(remaining > 0 ? int(remaining) : 0);
+    }
+
+    startBatch();
+}
+
+
+void FileWriter::syncFiles()
+{
+    // when a batch is running, its end starts the timer again
+    if (m_runningJobs.isEmpty())
+        startBatch();
+}
+
+
+bool FileWriter::hasPendingJobs(const QString &filePath) const
+{
+    Q_FOREACH(const Job & job, m_runningJobs)
+    {
+        if (job.filePath == filePath)
+            return true;
+    }
+    Q_FOREACH(const Job & job, m_jobs)
+    {
+        if (job.filePath == filePath)
+            return true;
+    }
+    return false;
+}
+
+
+QList<FileWriter::JobResult> FileWriter::runBatch(const QList<Job> &jobs, bool sync)
+{
+    QList<JobResult> results;
+
+    QElapsedTimer timer;
+    Q_FOREACH(const Job & job, jobs)
+    {
+        JobResult result;
+        result.type = job.type;
+        result.filePath = job.filePath;
+        result.synced = sync;
+
+        timer.start();
+        result.ok = runJob(job, sync, &result.bytes);
+        result.time = timer.nsecsElapsed();
+
+        results << result;
+    }
+
+    return results;
+}
+
+
+bool FileWriter::runJob(const Job &job, bool sync, qint64 *bytes)
+{
+    *bytes = 0;
+
+    switch (job.type)
+    {
+    case ReplaceJob:
+    {
+        // Written aside, then renamed over the old file. KSaveFile just fsyncs
+        // when asked to (KDE_EXTRA_FSYNC): the data is synced here, before
+        KSaveFile file(job.filePath);
+        if (!file.open())
+            return false;
+
+        if (file.write(job.data) != job.data.size() || !syncFile(file))
+        {
+            file.abort();
+            return false;
+        }
+        *bytes = job.data.size();
+
+        return file.finalize();
+    }
+
+    case AppendJob:
+    {
+        QFile file(job.filePath);
+        if (!file.open(QFile::WriteOnly | QFile::Append))
+            return false;
+
+        const qint64 written = file.write(job.data);
+        if (written > 0)
+            *bytes = written;
+
+        return written == job.data.size() && (sync ? syncFile(file) : file.flush());
+    }
+
+    case RemoveJob:
+        return !QFile::exists(job.filePath) || QFile::remove(job.filePath);
+
+    case SyncJob:
+    {
+        QFile file(job.filePath);
+        return file.open(QFile::WriteOnly | QFile::Append) && syncFile(file);
+    }
+    }
+
+    return false;
+}
@@ -0,0 +1,139 @@
+/* ============================================================
+*
+* This file is a part of the rekonq project
+*
+* Copyright (C) 2012 by Andrea Diamantini <adjam7 at gmail dot com>
+*
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as
+* published by the Free Software Foundation; either version 2 of
+* the License or (at your option) version 3 or any later version
+* accepted by the membership of KDE e.V. (or its successor approved
+* by the membership of KDE e.V.), which shall act as a proxy
+* defined in Section 14 of version 3 of the license.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* ============================================================ */
+
+
+
+
+#ifndef FILE_WRITER_H
+#define FILE_WRITER_H
+
+
+// Rekonq Includes
+#include "rekonq_defines.h"
+
+// Qt Includes
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+// Forward Declarations
+class QTimer;
+
+
+/**
+ * Writes the files of history, session and downloads in a worker thread,
+ * so that a slow disk never stalls the GUI.
+ *
+ * Managers hand it the data to write, already serialized: writes are done
+ * in order, a batch at a time. A replaced file is written with KSaveFile
+ * (aside, synced and renamed over the old one), so it is never found half
+ * written. Pending writes of a file replaced or removed are dropped.
+ * Appended data is synced at most every syncInterval() ms: see the
+ * fileSyncInterval setting. Slow writes are reported in the debug output.
+ *
+ */
+class REKONQ_TESTS_EXPORT FileWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FileWriter(QObject *parent = 0);
+
+    // waits for the pending writes
+    ~FileWriter();
+
+    void replaceFile(const QString &filePath, const QByteArray &data);
+    void appendToFile(const QString &filePath, const QByteArray &data);
+    void removeFile(const QString &filePath);
+
+    // Wait for the pending writes (of filePath, or of every file)
+    void flush(const QString &filePath = QString());
+
+    // ms between syncs of appended data. 0 syncs every write
+    int syncInterval() const
+    {
+        return m_syncInterval;
+    }
+    void setSyncInterval(int msecs);
+
+Q_SIGNALS:
+    // a write (or removal) of filePath has been done
+    void fileWritten(const QString &filePath, bool ok);
+
+private Q_SLOTS:
+    void batchFinished();
+    void syncFiles();
+
+private:
+    enum JobType
+    {
+        ReplaceJob,
+        AppendJob,
+        RemoveJob,
+        SyncJob
+    };
+
+    struct Job
+    {
+        JobType type;
+        QString filePath;
+        QByteArray data;
+    };
+
+    struct JobResult
+    {
+        JobType type;
+        QString filePath;
+        bool ok;
+        bool synced;
+        qint64 bytes;
+        qint64 time;
+    };
+
+    void addJob(JobType type, const QString &filePath, const QByteArray &data = QByteArray());
+    void startBatch();
+    bool hasPendingJobs(const QString &filePath) const;
+
+    // run in the worker thread
+    static QList<JobResult> runBatch(const QList<Job> &jobs, bool sync);
+    static bool runJob(const Job &job, bool sync, qint64 *bytes);
+
+    QList<Job> m_jobs;
+    QList<Job> m_runningJobs;
+    QFutureWatcher<QList<JobResult> > m_batchWatcher;
+
+    int m_syncInterval;
+    QElapsedTimer m_lastSync;
+    QTimer *m_syncTimer;
+
+    // files appended to, and not synced yet
+    QSet<QString> m_unsyncedFiles;
+};
+
+#endif // FILE_WRITER_H
@@ -0,0 +1,343 @@
+/* ============================================================
+*
+* This file is a part of the rekonq project
+*
+* Copyright (C) 2012 by Andrea Diamantini <adjam7 at gmail dot com>
+*
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as
+* published by the Free Software Foundation; either version 2 of
+* the License or (at your option) version 3 or any later version
+* accepted by the membership of KDE e.V. (or its successor approved
+* by the membership of KDE e.V.), which shall act as a proxy
+* defined in Section 14 of version 3 of the license.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* ============================================================ */
+
+
+
+
+// Self Includes
+#include "historyfile.h"
+
+// Rekonq Includes
+#include "rekonq_defines.h"
+
+// Local Includes
+#include "historymanager.h"
+
+// Qt Includes
+#include <QFile>
+#include <QSet>
+#include <QVector>
+#include <QtEndian>
+
+#include <string.h>
+
+
+static const quint32 HISTORY_MAGIC = 0x524B4846;   // "RKHF"
+static const quint32 SEGMENT_MAGIC = 0x524B4853;   // "RKHS"
+static const quint32 TRAILER_MAGIC = 0x524B4845;   // "RKHE"
+
+// NOTE: increase this every time the file format changes.
+// Versions 23 to 25 were the ones of the QDataStream history file
+static const quint32 HISTORY_VERSION = 26;
+
+// all numbers are little endian
+static const int fileHeaderSize = 8;        // magic, version
+static const int segmentHeaderSize = 16;    // magic, records, removed urls, string table length
+static const int recordSize = 40;           // first visit, last visit, visits, url, title, reserved
+static const int removedUrlSize = 8;        // url
+static const int trailerSize = 8;           // segment size, magic
+
+
+static inline qint64 segmentSize(quint32 records, quint32 removedUrls, quint32 stringLength)
+{
+    // the string table is padded to keep the next segment aligned
+    const qint64 stringTableSize = (qint64(stringLength) * 2 + 7) & ~qint64(7);
+    return segmentHeaderSize
+           + qint64(records) * recordSize
+           + qint64(removedUrls) * removedUrlSize
+           + stringTableSize
+           + trailerSize;
+}
+
+
+// Is a string reference (at reference: offset, length) all in the table?
+static inline bool isString(quint32 stringLength, const uchar *reference)
+{
+    const quint32 offset = qFromLittleEndian<quint32>(reference);
+    const quint32 length = qFromLittleEndian<quint32>(reference + 4);
+    return offset <= stringLength && length <= stringLength - offset;
+}
+
+
+// A string from the table, checked by isString()
+static QString readString(const uchar *strings, const uchar *reference)
+{
+    const quint32 offset = qFromLittleEndian<quint32>(reference);
+    const quint32 length = qFromLittleEndian<quint32>(reference + 4);
+
+    const uchar *data = strings + qint64(offset) * 2;
+    QString string(length, Qt::Uninitialized);
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    memcpy(string.data(), data, length * 2);
+#else
+    QChar *chars = string.data();
+    for (quint32 i = 0; i < length; ++i)
+        chars[i] = QChar(qFromLittleEndian<quint16>(data + i * 2));
+#endif
+
+    return string;
+}
+
+
+static void writeString(const QString &string, uchar *strings, quint32 *offset, uchar *reference)
+{
+    qToLittleEndian<quint32>(*offset, reference);
+    qToLittleEndian<quint32>(string.length(), reference + 4);
+
+    uchar *data = strings + qint64(*offset) * 2;
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    memcpy(data, string.constData(), string.length() * 2);
+#else
+    for (int i = 0; i < string.length(); ++i)
+        qToLittleEndian<quint16>(string.at(i).unicode(), data + i * 2);
+#endif
+
+    *offset += string.length();
+}
+
+
+HistoryFile::HistoryFile(const QString &filePath)
+    : m_filePath(filePath)
+    , m_validSize(0)
+    , m_recordCount(0)
+{
+}
+
+
+bool HistoryFile::load(QList<HistoryItem> *items)
+{
+    m_validSize = 0;
+    m_recordCount = 0;
+
+    QFile file(m_filePath);
+    if (!file.open(QFile::ReadOnly))
+    {
+        kDebug() << "Unable to open history file" << m_filePath;
+        return false;
+    }
+
+    const qint64 size = file.size();
+    if (size < fileHeaderSize)
+        return false;
+
+    const uchar *map = file.map(0, size);
+    if (!map)
+    {
+        kDebug() << "Unable to map history file" << m_filePath;
+        return false;
+    }
+
+    if (qFromLittleEndian<quint32>(map) != HISTORY_MAGIC
+            || qFromLittleEndian<quint32>(map + 4) != HISTORY_VERSION)
+    {
+        file.unmap(const_cast<uchar *>(map));
+        return false;
+    }
+
+    // the good segments: what follows them was left by an interrupted save
+    QVector<qint64> segments;
+
+    qint64 offset = fileHeaderSize;
+    while (offset + segmentHeaderSize + trailerSize <= size)
+    {
+        const uchar *segment = map + offset;
+        if (qFromLittleEndian<quint32>(segment) != SEGMENT_MAGIC)
+            break;
+
+        const quint32 recordCount = qFromLittleEndian<quint32>(segment + 4);
+        const quint32 removedCount = qFromLittleEndian<quint32>(segment + 8);
+        const quint32 stringLength = qFromLittleEndian<quint32>(segment + 12);
+
+        const qint64 thisSegmentSize = segmentSize(recordCount, removedCount, stringLength);
+        if (offset + thisSegmentSize > size)
+            break;
+
+        const uchar *trailer = segment + thisSegmentSize - trailerSize;
+        if (qFromLittleEndian<quint32>(trailer) != quint32(thisSegmentSize)
+                || qFromLittleEndian<quint32>(trailer + 4) != TRAILER_MAGIC)
+            break;
+
+        // check the whole segment, before using it
+        bool isGood = true;
+
+        const uchar *record = segment + segmentHeaderSize;
+        for (quint32 i = 0; isGood && i < recordCount; ++i, record += recordSize)
+            isGood = isString(stringLength, record + 20) && isString(stringLength, record + 28);
+
+        const uchar *removedUrl = record;
+        for (quint32 i = 0; isGood && i < removedCount; ++i, removedUrl += removedUrlSize)
+            isGood = isString(stringLength, removedUrl);
+
+        if (!isGood)
+            break;
+
+        segments << offset;
+        m_recordCount += recordCount + removedCount;
+        offset += thisSegmentSize;
+    }
+
+    // Read back to front: the last record of an url is its live one, and so are
+    // the urls removed. Older records of the urls seen are dead, and skipped
+    QList<HistoryItem> fileItems;
+    QSet<QString> urls;
+
+    for (int s = segments.count() - 1; s >= 0; --s)
+    {
+        const uchar *segment = map + segments.at(s);
+        const quint32 recordCount = qFromLittleEndian<quint32>(segment + 4);
+        const quint32 removedCount = qFromLittleEndian<quint32>(segment + 8);
+
+        const uchar *records = segment + segmentHeaderSize;
+        const uchar *removedUrls = records + qint64(recordCount) * recordSize;
+        const uchar *strings = removedUrls + qint64(removedCount) * removedUrlSize;
+
+        for (qint64 i = qint64(recordCount) - 1; i >= 0; --i)
+        {
+            const uchar *record = records + i * recordSize;
+            const QString url = readString(strings, record + 20);
+            if (urls.contains(url))
+                continue;
+
+            urls.insert(url);
+
+            HistoryItem item(url, fromEpoch(qFromLittleEndian<qint64>(record + 8)), readString(strings, record + 28));
+            item.firstDateTimeVisit = fromEpoch(qFromLittleEndian<qint64>(record));
+            item.visitCount = qFromLittleEndian<quint32>(record + 16);
+            fileItems.prepend(item);
+        }
+
+        // urls were removed before the items of the same segment were (visited and) saved
+        for (quint32 i = 0; i < removedCount; ++i)
+            urls.insert(readString(strings, removedUrls + qint64(i) * removedUrlSize));
+    }
+
+    file.unmap(const_cast<uchar *>(map));
+    file.close();
+
+    // what follows was left by an interrupted save: drop it, before appending
+    m_validSize = offset;
+    if (offset != size)
+    {
+        kDebug() << "Discarding" << size - offset << "bytes at the end of history file";
+        if (!file.resize(offset))
+            kDebug() << "Unable to truncate history file" << m_filePath;
+    }
+
+    *items += fileItems;
+    return true;
+}
+
+
+QByteArray HistoryFile::appendData(const QList<HistoryItem> &items, const QStringList &removedUrls)
+{
+    if (items.isEmpty() && removedUrls.isEmpty())
+        return QByteArray();
+
+    QByteArray data;
+
+    // a new file
+    if (m_validSize < fileHeaderSize)
+    {
+        data = fileHeader();
+        m_recordCount = 0;
+    }
+
+    data += segment(items, removedUrls);
+
+    m_validSize += data.size();
+    m_recordCount += items.count() + removedUrls.count();
+    return data;
+}
+
+
+QByteArray HistoryFile::rewriteData(const QList<HistoryItem> &items)
+{
+    const QByteArray data = fileHeader() + segment(items, QStringList());
+
+    m_validSize = data.size();
+    m_recordCount = items.count();
+    return data;
+}
+
+
+QByteArray HistoryFile::fileHeader()
+{
+    QByteArray data(fileHeaderSize, 0);
+    uchar *header = reinterpret_cast<uchar *>(data.data());
+    qToLittleEndian<quint32>(HISTORY_MAGIC, header);
+    qToLittleEndian<quint32>(HISTORY_VERSION, header + 4);
+    return data;
+}
+
+
+QByteArray HistoryFile::segment(const QList<HistoryItem> &items, const QStringList &removedUrls)
+{
+    quint32 stringLength = 0;
+    Q_FOREACH(const HistoryItem & item, items)
+    {
+        stringLength += item.url.length() + item.title.length();
+    }
+    Q_FOREACH(const QString & url, removedUrls)
+    {
+        stringLength += url.length();
+    }
+
+    const qint64 size = segmentSize(items.count(), removedUrls.count(), stringLength);
+    QByteArray data(size, 0);
+    uchar *segment = reinterpret_cast<uchar *>(data.data());
+
+    qToLittleEndian<quint32>(SEGMENT_MAGIC, segment);
+    qToLittleEndian<quint32>(items.count(), segment + 4);
+    qToLittleEndian<quint32>(removedUrls.count(), segment + 8);
+    qToLittleEndian<quint32>(stringLength, segment + 12);
+
+    uchar *record = segment + segmentHeaderSize;
+    uchar *removedUrl = record + qint64(items.count()) * recordSize;
+    uchar *strings = removedUrl + qint64(removedUrls.count()) * removedUrlSize;
+    quint32 stringOffset = 0;
+
+    Q_FOREACH(const HistoryItem & item, items)
+    {
+        qToLittleEndian<qint64>(toEpoch(item.firstDateTimeVisit), record);
+        qToLittleEndian<qint64>(toEpoch(item.lastDateTimeVisit), record + 8);
+        qToLittleEndian<quint32>(item.visitCount, record + 16);
+        writeString(item.url, strings, &stringOffset, record + 20);
+        writeString(item.title, strings, &stringOffset, record + 28);
+        record += recordSize;
+    }
+
+    Q_FOREACH(const QString & url, removedUrls)
+    {
+        writeString(url, strings, &stringOffset, removedUrl);
+        removedUrl += removedUrlSize;
+    }
+
+    uchar *trailer = segment + size - trailerSize;
+    qToLittleEndian<quint32>(size, trailer);
+    qToLittleEndian<quint32>(TRAILER_MAGIC, trailer + 4);
+
+    return data;
+}
@@ -0,0 +1,112 @@
+/* ============================================================
+*
+* This file is a part of the rekonq project
+*
+* Copyright (C) 2012 by Andrea Diamantini <adjam7 at gmail dot com>
+*
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as
+* published by the Free Software Foundation; either version 2 of
+* the License or (at your option) version 3 or any later version
+* accepted by the membership of KDE e.V. (or its successor approved
+* by the membership of KDE e.V.), which shall act as a proxy
+* defined in Section 14 of version 3 of the license.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* ============================================================ */
+
+
+
+
+#ifndef HISTORYFILE_H
+#define HISTORYFILE_H
+
+
+// Rekonq Includes
+#include "rekonq_defines.h"
+
+// Qt Includes
+#include <QByteArray>
+#include <QDateTime>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// Forward Declarations
+class HistoryItem;
+
+
+/**
+ * The history file: a header, then one segment per save.
+ *
+ * A segment has a fixed size record per visited item (dates, visits and the
+ * offsets of its url and title), the urls removed since the previous save,
+ * the string table with their texts and a trailer. A segment is good just when
+ * its trailer is there, so a save interrupted midway is discarded on next load.
+ *
+ * The file is memory mapped to load it, and appended to on save: records of
+ * items visited again, or removed, are dead from then on. Loading reads them
+ * all, dead ones included: HistoryManager rewrites the file when they are too
+ * many, on save or right after loading it.
+ *
+ * HistoryFile just prepares the data to write: FileWriter writes it.
+ *
+ */
+class REKONQ_TESTS_EXPORT HistoryFile
+{
+public:
+    explicit HistoryFile(const QString &filePath);
+
+    QString filePath() const
+    {
+        return m_filePath;
+    }
+
+    // Read the items in the file, oldest first, one per url.
+    // Returns false when the file is not in this format (eg: an old one)
+    bool load(QList<HistoryItem> *items);
+
+    // The data to append to the file, to add the (oldest first) items
+    // and the removed urls. From now on, the file is supposed to have it
+    QByteArray appendData(const QList<HistoryItem> &items, const QStringList &removedUrls);
+
+    // The same, to replace the file contents with the (oldest first) items
+    QByteArray rewriteData(const QList<HistoryItem> &items);
+
+    // records in the file, live or dead ones
+    int recordCount() const
+    {
+        return m_recordCount;
+    }
+
+    // Dates as they are stored, here and in HistoryList: epoch milliseconds, 0 when invalid
+    static qint64 toEpoch(const QDateTime &dateTime)
+    {
+        return dateTime.isValid() ? dateTime.toMSecsSinceEpoch() : 0;
+    }
+
+    static QDateTime fromEpoch(qint64 msecs)
+    {
+        return msecs ? QDateTime::fromMSecsSinceEpoch(msecs) : QDateTime();
+    }
+
+private:
+    static QByteArray fileHeader();
+    static QByteArray segment(const QList<HistoryItem> &items, const QStringList &removedUrls);
+
+    QString m_filePath;
+
+    // size of the good part of the file, and its records
+    qint64 m_validSize;
+    int m_recordCount;
+};
+
+#endif // HISTORYFILE_H
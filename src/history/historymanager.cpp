@@ -37,6 +37,7 @@
 #include "historymodels.h"
 #include "autosaver.h"
 #include "application.h"
+#include "filewriter.h"
 
 // KDE Includes
 #include <KStandardDirs>
@@ -45,6 +46,7 @@
 
 // Qt Includes
 #include <QList>
+#include <QPair>
 #include <QUrl>
 #include <QDate>
 #include <QDateTime>
@@ -52,28 +54,838 @@
 #include <QFile>
 #include <QDataStream>
 #include <QBuffer>
-#include <QTemporaryFile>
 #include <QTimer>
 
 #include <QClipboard>
 
 // generic algorithms
 #include <QtAlgorithms>
+#include <algorithm>
+#include <functional>
 
+#include <string.h>
 
-static const unsigned int HISTORY_VERSION = 25;
+
+// dead records in the history file are dropped just when they are many, and more than the live ones
+static const int minDeadRecordsToCompact = 1024;
+
+// holes in the HistoryList slots are dropped just when they are many, and more than the items
+static const int minHolesToCompact = 1024;
+
+// the url index of HistoryList has at least these buckets, and uses at most half of them
+static const int minBuckets = 64;
+
+
+// Length of the scheme and host of an url, interned by HistoryList:
+// "http://kde.org" of "http://kde.org/news", "about:" of "about:blank"
+static int prefixLength(const QString &url)
+{
+    const int schemeEnd = url.indexOf(QL1C(':'));
+    if (schemeEnd == -1)
+        return 0;
+
+    const int hostStart = schemeEnd + 3;
+    if (url.length() < hostStart || url.at(schemeEnd + 1) != QL1C('/') || url.at(schemeEnd + 2) != QL1C('/'))
+        return schemeEnd + 1;
+
+    for (int i = hostStart; i < url.length(); ++i)
+    {
+        const QChar c = url.at(i);
+        if (c == QL1C('/') || c == QL1C('?') || c == QL1C('#'))
+            return i;
+    }
+    return url.length();
+}
+
+
+static inline uint keyHash(int prefix, const QByteArray &path)
+{
+    return qHash(path) ^ (uint(prefix) * 2654435761U);
+}
+
+
+HistoryList::HistoryList()
+    : m_tree(1, 0)
+    , m_buckets(minBuckets, -1)
+    , m_usedBuckets(0)
+    , m_count(0)
+    , m_serial(-1)
+{
+}
+
+
+HistoryItem HistoryList::at(int row) const
+{
+    return item(slot(m_count - 1 - row));
+}
+
+
+HistoryItem HistoryList::last() const
+{
+    return item(slot(0));
+}
+
+
+QDateTime HistoryList::lastDateTimeVisitAt(int row) const
+{
+    return HistoryFile::fromEpoch(m_slots.at(slot(m_count - 1 - row)).lastVisit);
+}
+
+
+int HistoryList::row(const QString &url) const
+{
+    const int urlSlot = findSlot(url);
+    if (urlSlot == -1)
+        return -1;
+
+    return m_count - 1 - itemsBefore(urlSlot);
+}
+
+
+void HistoryList::prepend(const HistoryItem &item)
+{
+    const int length = prefixLength(item.url);
+
+    Key itemKey;
+    itemKey.prefix = internPrefix(item.url.left(length));
+    itemKey.path = item.url.mid(length).toUtf8();
+    itemKey.hash = keyHash(itemKey.prefix, itemKey.path);
+
+    const QByteArray title = item.title.toUtf8();
+
+    Slot newSlot;
+    newSlot.firstVisit = HistoryFile::toEpoch(item.firstDateTimeVisit);
+    newSlot.lastVisit = HistoryFile::toEpoch(item.lastDateTimeVisit);
+    newSlot.serial = ++m_serial;
+    newSlot.visitCount = item.visitCount;
+    newSlot.prefix = itemKey.prefix;
+    newSlot.pathLength = itemKey.path.length();
+    newSlot.titleLength = title.length();
+    newSlot.hash = itemKey.hash;
+
+    // a visit again: its strings are there already (the title, most of the times)
+    const int oldSlot = findSlot(itemKey);
+    if (oldSlot != -1)
+    {
+        const Slot &old = m_slots.at(oldSlot);
+        newSlot.path = old.path;
+        newSlot.title = isString(old.title, old.titleLength, title) ? old.title : appendString(title);
+
+        removeSlot(oldSlot);
+        makeHole(oldSlot);
+    }
+    else
+    {
+        newSlot.path = appendString(itemKey.path);
+        newSlot.title = appendString(title);
+    }
+
+    const int size = m_slots.count() + 1;
+    insertSlot(size - 1, newSlot.hash);
+    m_slots.append(newSlot);
+
+    // the new tree node counts the items in the slots (size - lowbit(size), size]
+    m_tree.append(1 + itemsBefore(size - 1) - itemsBefore(size - (size & -size)));
+    m_count++;
+
+    compact();
+}
+
+
+HistoryItem HistoryList::take(const QString &url)
+{
+    const int urlSlot = findSlot(url);
+    if (urlSlot == -1)
+        return HistoryItem();
+
+    const HistoryItem urlItem = item(urlSlot);
+    removeSlot(urlSlot);
+    makeHole(urlSlot);
+    compact();
+    return urlItem;
+}
+
+
+HistoryItem HistoryList::takeLast()
+{
+    const int lastSlot = slot(0);
+    const HistoryItem lastItem = item(lastSlot);
+
+    removeSlot(lastSlot);
+    makeHole(lastSlot);
+    compact();
+    return lastItem;
+}
+
+
+void HistoryList::clear()
+{
+    // NOTE: serials are not reset. They just grow.
+    m_slots.clear();
+    m_tree = QVector<int>(1, 0);
+    m_buckets = QVector<int>(minBuckets, -1);
+    m_usedBuckets = 0;
+    m_prefixes.clear();
+    m_prefixIds.clear();
+    m_strings.clear();
+    m_count = 0;
+}
+
+
+QList<HistoryItem> HistoryList::toList() const
+{
+    QList<HistoryItem> list;
+    list.reserve(m_count);
+    for (int i = m_slots.count() - 1; i >= 0; --i)
+    {
+        if (m_slots.at(i).prefix != -1)
+            list << item(i);
+    }
+    return list;
+}
+
+
+QList<HistoryItem> HistoryList::itemsSince(int serial) const
+{
+    // slots are sorted by serial: look for the first one after serial
+    int low = 0;
+    int high = m_slots.count();
+    while (low < high)
+    {
+        const int middle = (low + high) / 2;
+        if (m_slots.at(middle).serial <= serial)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    QList<HistoryItem> list;
+    for (int i = low; i < m_slots.count(); ++i)
+    {
+        if (m_slots.at(i).prefix != -1)
+            list << item(i);
+    }
+    return list;
+}
+
+
+int HistoryList::serialAt(int row) const
+{
+    return m_slots.at(slot(m_count - 1 - row)).serial;
+}
+
+
+HistoryItem HistoryList::itemWithSerial(int serial) const
+{
+    int low = 0;
+    int high = m_slots.count();
+    while (low < high)
+    {
+        const int middle = (low + high) / 2;
+        if (m_slots.at(middle).serial < serial)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    if (low == m_slots.count() || m_slots.at(low).serial != serial || m_slots.at(low).prefix == -1)
+        return HistoryItem();
+
+    return item(low);
+}
+
+
+int HistoryList::slot(int n) const
+{
+    Q_ASSERT(n >= 0 && n < m_count);
+
+    const int size = m_slots.count();
+    int step = 1;
+    while (step * 2 <= size)
+        step *= 2;
+
+    // descend the tree, looking for the last position with less than n + 1 items before
+    int position = 0;
+    int remaining = n + 1;
+    for (; step > 0; step /= 2)
+    {
+        const int next = position + step;
+        if (next <= size && m_tree.at(next) < remaining)
+        {
+            position = next;
+            remaining -= m_tree.at(next);
+        }
+    }
+
+    return position;
+}
+
+
+int HistoryList::itemsBefore(int slot) const
+{
+    int items = 0;
+    for (int i = slot; i > 0; i -= (i & -i))
+        items += m_tree.at(i);
+    return items;
+}
+
+
+void HistoryList::addToTree(int slot, int delta)
+{
+    const int size = m_slots.count();
+    for (int i = slot + 1; i <= size; i += (i & -i))
+        m_tree[i] += delta;
+}
+
+
+void HistoryList::makeHole(int slot)
+{
+    // its strings stay in the arena, till compact()
+    m_slots[slot].prefix = -1;
+
+    addToTree(slot, -1);
+    m_count--;
+}
+
+
+void HistoryList::compact()
+{
+    const int holes = m_slots.count() - m_count;
+    if (holes < minHolesToCompact || holes <= m_count)
+        return;
+
+    // the strings of the holes go too
+    QVector<Slot> slots;
+    slots.reserve(m_count);
+    QByteArray strings;
+    strings.reserve(m_strings.size() / 2);
+    Q_FOREACH(Slot s, m_slots)
+    {
+        if (s.prefix == -1)
+            continue;
+
+        const int path = strings.size();
+        strings.append(m_strings.constData() + s.path, s.pathLength);
+        s.path = path;
+
+        const int title = strings.size();
+        strings.append(m_strings.constData() + s.title, s.titleLength);
+        s.title = title;
+
+        slots << s;
+    }
+    m_slots = slots;
+    m_strings = strings;
+
+    int buckets = minBuckets;
+    while (buckets < m_count * 4)
+        buckets *= 2;
+    rehash(buckets);
+
+    // every slot has an item now: rebuild the tree in linear time
+    const int size = m_slots.count();
+    m_tree = QVector<int>(size + 1, 0);
+    for (int i = 1; i <= size; ++i)
+    {
+        m_tree[i] += 1;
+        const int parent = i + (i & -i);
+        if (parent <= size)
+            m_tree[parent] += m_tree.at(i);
+    }
+}
+
+
+HistoryItem HistoryList::item(int slot) const
+{
+    const Slot &s = m_slots.at(slot);
+
+    HistoryItem slotItem(url(slot), HistoryFile::fromEpoch(s.lastVisit),
+                         QString::fromUtf8(m_strings.constData() + s.title, s.titleLength));
+    slotItem.firstDateTimeVisit = HistoryFile::fromEpoch(s.firstVisit);
+    slotItem.visitCount = s.visitCount;
+    return slotItem;
+}
+
+
+QString HistoryList::url(int slot) const
+{
+    const Slot &s = m_slots.at(slot);
+    return m_prefixes.at(s.prefix) + QString::fromUtf8(m_strings.constData() + s.path, s.pathLength);
+}
+
+
+HistoryList::Key HistoryList::key(const QString &url) const
+{
+    const int length = prefixLength(url);
+
+    Key urlKey;
+    urlKey.prefix = m_prefixIds.value(url.left(length), -1);
+    if (urlKey.prefix == -1)
+        return urlKey;
+
+    urlKey.path = url.mid(length).toUtf8();
+    urlKey.hash = keyHash(urlKey.prefix, urlKey.path);
+    return urlKey;
+}
+
+
+int HistoryList::internPrefix(const QString &prefix)
+{
+    QHash<QString, int>::const_iterator it = m_prefixIds.constFind(prefix);
+    if (it != m_prefixIds.constEnd())
+        return it.value();
+
+    m_prefixes << prefix;
+    m_prefixIds.insert(prefix, m_prefixes.count() - 1);
+    return m_prefixes.count() - 1;
+}
+
+
+int HistoryList::findSlot(const QString &url) const
+{
+    return findSlot(key(url));
+}
+
+
+int HistoryList::findSlot(const Key &key) const
+{
+    // hosts never seen
+    if (key.prefix == -1)
+        return -1;
+
+    const int mask = m_buckets.count() - 1;
+    for (int i = key.hash & mask; ; i = (i + 1) & mask)
+    {
+        const int bucket = m_buckets.at(i);
+        if (bucket == -1)
+            return -1;
+        if (bucket < 0)
+            continue;
+
+        const Slot &s = m_slots.at(bucket);
+        if (s.hash == key.hash && s.prefix == key.prefix && isString(s.path, s.pathLength, key.path))
+            return bucket;
+    }
+}
+
+
+void HistoryList::insertSlot(int slot, uint hash)
+{
+    if ((m_usedBuckets + 1) * 2 > m_buckets.count())
+    {
+        int buckets = minBuckets;
+        while (buckets < (m_count + 1) * 4)
+            buckets *= 2;
+        rehash(buckets);
+    }
+
+    const int mask = m_buckets.count() - 1;
+    int i = hash & mask;
+    while (m_buckets.at(i) >= 0)
+        i = (i + 1) & mask;
+
+    if (m_buckets.at(i) == -1)
+        m_usedBuckets++;
+    m_buckets[i] = slot;
+}
+
+
+void HistoryList::removeSlot(int slot)
+{
+    const int mask = m_buckets.count() - 1;
+    int i = m_slots.at(slot).hash & mask;
+    while (m_buckets.at(i) != slot)
+        i = (i + 1) & mask;
+
+    // removed, not empty: the buckets after it can still be in the same chain
+    m_buckets[i] = -2;
+}
+
+
+void HistoryList::rehash(int buckets)
+{
+    m_buckets = QVector<int>(buckets, -1);
+    m_usedBuckets = 0;
+
+    const int mask = buckets - 1;
+    for (int slot = 0; slot < m_slots.count(); ++slot)
+    {
+        const Slot &s = m_slots.at(slot);
+        if (s.prefix == -1)
+            continue;
+
+        int i = s.hash & mask;
+        while (m_buckets.at(i) != -1)
+            i = (i + 1) & mask;
+
+        m_buckets[i] = slot;
+        m_usedBuckets++;
+    }
+}
+
+
+int HistoryList::appendString(const QByteArray &string)
+{
+    const int offset = m_strings.size();
+    m_strings.append(string);
+    return offset;
+}
+
+
+bool HistoryList::isString(int offset, int length, const QByteArray &string) const
+{
+    return length == string.length()
+           && memcmp(m_strings.constData() + offset, string.constData(), length) == 0;
+}
+
+
+// ---------------------------------------------------------------------------------------------------------------
+
+
+// dead items in the HistoryIndex are dropped just when they are many, and more than the live ones
+static const int minDeadItemsToCompact = 1024;
+
+
+static inline quint64 trigramKey(const QChar *c)
+{
+    return (quint64(c[0].unicode()) << 32) | (quint64(c[1].unicode()) << 16) | quint64(c[2].unicode());
+}
+
+
+// The (unique) trigrams of a lowercase text
+static QVector<quint64> trigrams(const QString &text)
+{
+    QVector<quint64> keys;
+    if (text.length() < 3)
+        return keys;
+
+    keys.reserve(text.length() - 2);
+    const QChar *data = text.constData();
+    for (int i = 0; i + 3 <= text.length(); ++i)
+        keys << trigramKey(data + i);
+
+    qSort(keys);
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return keys;
+}
+
+
+HistoryIndex::HistoryIndex(HistoryManager *manager)
+    : QObject(manager)
+    , m_manager(manager)
+    , m_deadCount(0)
+    , m_revision(0)
+{
+}
+
+
+QList<HistoryItem> HistoryIndex::find(const QStringList &words) const
+{
+    const QVector<int> ids = findIds(words);
+
+    QList<HistoryItem> list;
+    list.reserve(ids.count());
+    for (int i = ids.count() - 1; i >= 0; --i)
+        list << item(ids.at(i));
+
+    return list;
+}
+
+
+QList<HistoryItem> HistoryIndex::findRelevant(const QStringList &words, int count, HistorySearch *search) const
+{
+    QList<HistoryItem> list;
+    if (count <= 0)
+        return list;
+
+    QVector<int> ids;
+    if (search && search->m_revision == m_revision && isRefinement(words, search->m_words))
+    {
+        // just the items found for less (or the same) words can be there
+        if (words == search->m_words)
+        {
+            ids = search->m_ids;
+        }
+        else
+        {
+            Q_FOREACH(const int id, search->m_ids)
+            {
+                const HistoryItem idItem = item(id);
+                if (!idItem.url.isEmpty() && matches(idItem, words))
+                    ids << id;
+            }
+        }
+    }
+    else
+    {
+        ids = findIds(words);
+    }
+
+    if (search)
+    {
+        search->m_words = words;
+        search->m_ids = ids;
+        search->m_revision = m_revision;
+    }
+
+    const QDate today = QDate::currentDate();
+
+    // a min heap of the count most relevant items found so far:
+    // the least relevant is on top, to be replaced
+    typedef QPair<qreal, int> Candidate;
+    QVector<Candidate> heap;
+    heap.reserve(count + 1);
+
+    Q_FOREACH(const int id, ids)
+    {
+        // the most recent one wins, on equal relevance
+        const Candidate candidate(frecency(id, today), id);
+        if (heap.count() < count)
+        {
+            heap << candidate;
+            std::push_heap(heap.begin(), heap.end(), std::greater<Candidate>());
+        }
+        else if (heap.first() < candidate)
+        {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<Candidate>());
+            heap.last() = candidate;
+            std::push_heap(heap.begin(), heap.end(), std::greater<Candidate>());
+        }
+    }
+
+    std::sort_heap(heap.begin(), heap.end(), std::greater<Candidate>());
+
+    list.reserve(heap.count());
+    Q_FOREACH(const Candidate & candidate, heap)
+    {
+        list << item(candidate.second);
+    }
+    return list;
+}
+
+
+QVector<int> HistoryIndex::findIds(const QStringList &words) const
+{
+    QVector<int> ids;
+
+    // the posting lists of every trigram in the words, shortest first
+    QList<const QVector<int> *> postings;
+    Q_FOREACH(const QString & word, words)
+    {
+        Q_FOREACH(const quint64 key, trigrams(word.toLower()))
+        {
+            QHash<quint64, QVector<int> >::const_iterator it = m_postings.constFind(key);
+            if (it == m_postings.constEnd())
+                return ids;
+
+            int i = 0;
+            while (i < postings.count() && postings.at(i)->count() < it->count())
+                ++i;
+            postings.insert(i, &it.value());
+        }
+    }
+
+    // words too short to have trigrams: check every item
+    if (postings.isEmpty())
+    {
+        for (int id = 0; id < m_serials.count(); ++id)
+        {
+            const HistoryItem idItem = item(id);
+            if (!idItem.url.isEmpty() && matches(idItem, words))
+                ids << id;
+        }
+        return ids;
+    }
+
+    QVector<int> candidates = *postings.at(0);
+    for (int i = 1; i < postings.count() && !candidates.isEmpty(); ++i)
+    {
+        const QVector<int> &posting = *postings.at(i);
+
+        QVector<int> intersection;
+        Q_FOREACH(const int id, candidates)
+        {
+            if (qBinaryFind(posting.constBegin(), posting.constEnd(), id) != posting.constEnd())
+                intersection << id;
+        }
+        candidates = intersection;
+    }
+
+    // trigrams can be found in different places (or words): check the words
+    Q_FOREACH(const int id, candidates)
+    {
+        const HistoryItem idItem = item(id);
+        if (!idItem.url.isEmpty() && matches(idItem, words))
+            ids << id;
+    }
+
+    return ids;
+}
+
+
+void HistoryIndex::addItem(const HistoryItem &item)
+{
+    // just prepended to the history. Its previous visit was removed before
+    const int id = m_serials.count();
+    m_serials << m_manager->history().lastSerial();
+    addTrigrams(id, item);
+    m_revision++;
+
+    const QDate today = QDate::currentDate();
+    Frecency itemFrecency;
+    itemFrecency.score = item.relevance(today);
+    itemFrecency.day = today.toJulianDay();
+    m_frecencies << itemFrecency;
+}
+
+
+void HistoryIndex::itemsRemoved(int firstRow, int lastRow)
+{
+    // their ids are dead, as their serials are no more in history:
+    // searches found before can have them
+    m_deadCount += lastRow - firstRow + 1;
+    m_revision++;
+
+    compact();
+}
+
+
+void HistoryIndex::reset()
+{
+    m_serials.clear();
+    m_postings.clear();
+    m_deadCount = 0;
+    m_revision++;
+
+    // oldest first, as they were added
+    const HistoryList &history = m_manager->history();
+    m_serials.reserve(history.count());
+    for (int row = history.count() - 1; row >= 0; --row)
+    {
+        m_serials << history.serialAt(row);
+        addTrigrams(m_serials.count() - 1, history.at(row));
+    }
+
+    // computed when asked for
+    const Frecency noFrecency = { 0, -1 };
+    m_frecencies = QVector<Frecency>(m_serials.count(), noFrecency);
+}
+
+
+void HistoryIndex::addTrigrams(int id, const HistoryItem &item)
+{
+    // ids just grow: appending them keeps the lists sorted
+    const QString text = item.url.toLower() + QL1C('\n') + item.title.toLower();
+    Q_FOREACH(const quint64 key, trigrams(text))
+    {
+        m_postings[key] << id;
+    }
+}
+
+
+void HistoryIndex::compact()
+{
+    if (m_deadCount < minDeadItemsToCompact || m_deadCount <= m_serials.count() - m_deadCount)
+        return;
+
+    // give new ids to the live items, indexing them again
+    const QVector<int> serials = m_serials;
+    const QVector<Frecency> frecencies = m_frecencies;
+    m_serials.clear();
+    m_postings.clear();
+    m_frecencies.clear();
+    m_deadCount = 0;
+    m_revision++;
+
+    const HistoryList &history = m_manager->history();
+    for (int id = 0; id < serials.count(); ++id)
+    {
+        const HistoryItem serialItem = history.itemWithSerial(serials.at(id));
+        if (serialItem.url.isEmpty())
+            continue;
+
+        m_serials << serials.at(id);
+        m_frecencies << frecencies.at(id);
+        addTrigrams(m_serials.count() - 1, serialItem);
+    }
+}
+
+
+qreal HistoryIndex::frecency(int id, const QDate &today) const
+{
+    Frecency &itemFrecency = m_frecencies[id];
+
+    const int day = today.toJulianDay();
+    if (itemFrecency.day != day)
+    {
+        itemFrecency.score = item(id).relevance(today);
+        itemFrecency.day = day;
+    }
+    return itemFrecency.score;
+}
+
+
+bool HistoryIndex::isRefinement(const QStringList &words, const QStringList &searchWords)
+{
+    Q_FOREACH(const QString & searchWord, searchWords)
+    {
+        bool isContained = false;
+        Q_FOREACH(const QString & word, words)
+        {
+            if (word.contains(searchWord, Qt::CaseInsensitive))
+            {
+                isContained = true;
+                break;
+            }
+        }
+
+        if (!isContained)
+            return false;
+    }
+    return true;
+}
+
+
+HistoryItem HistoryIndex::item(int id) const
+{
+    return m_manager->history().itemWithSerial(m_serials.at(id));
+}
+
+
+bool HistoryIndex::matches(const HistoryItem &item, const QStringList &words)
+{
+    Q_FOREACH(const QString & word, words)
+    {
+        if (!item.url.contains(word, Qt::CaseInsensitive)
+                && !item.title.contains(word, Qt::CaseInsensitive))
+            return false;
+    }
+    return true;
+}
+
+
+// ---------------------------------------------------------------------------------------------------------------
 
 
 HistoryManager::HistoryManager(QObject *parent)
     : QObject(parent)
     , m_saveTimer(new AutoSaver(this))
     , m_historyLimit(0)
+    , m_lastSavedSerial(-1)
+    , m_historyFile(KStandardDirs::locateLocal("appdata" , "history"))
+    , m_historyIndex(new HistoryIndex(this))
     , m_historyTreeModel(0)
 {
     connect(this, SIGNAL(entryAdded(HistoryItem)), m_saveTimer, SLOT(changeOccurred()));
     connect(this, SIGNAL(entryRemoved(HistoryItem)), m_saveTimer, SLOT(changeOccurred()));
     connect(m_saveTimer, SIGNAL(saveNeeded()), this, SLOT(save()));
 
+    connect(rApp->fileWriter(), SIGNAL(fileWritten(QString, bool)), this, SLOT(fileWritten(QString, bool)));
+
+    connect(this, SIGNAL(entryAdded(HistoryItem)), m_historyIndex, SLOT(addItem(HistoryItem)));
+    connect(this, SIGNAL(entriesRemoved(int, int)), m_historyIndex, SLOT(itemsRemoved(int, int)));
+    connect(this, SIGNAL(historyReset()), m_historyIndex, SLOT(reset()));
+
     load();
 
     HistoryModel *historyModel = new HistoryModel(this, this);
@@ -87,6 +899,7 @@ HistoryManager::~HistoryManager()
     if (ReKonfig::expireHistory() == 4)
     {
         m_history.clear();
+        m_lastSavedSerial = -1;
         save();
         return;
     }
@@ -96,7 +909,7 @@ HistoryManager::~HistoryManager()
 
 bool HistoryManager::historyContains(const QString &url) const
 {
-    return m_historyFilterModel->historyContains(url);
+    return m_history.contains(url);
 }
 
 
@@ -129,10 +942,7 @@ void HistoryManager::addHistoryEntry(const KUrl &url, const QString &title)
     // if so, remove previous entry from history, update and prepend it
     if (historyContains(urlString))
     {
-        int index = m_historyFilterModel->historyLocation(urlString);
-        item = m_history.at(index);
-        m_history.removeOne(item);
-        emit entryRemoved(item);
+        item = takeHistoryRows(m_history.row(urlString), 1).first();
 
         item.lastDateTimeVisit = QDateTime::currentDateTime();
         item.visitCount++;
@@ -152,21 +962,29 @@ void HistoryManager::addHistoryEntry(const KUrl &url, const QString &title)
 
 void HistoryManager::setHistory(const QList<HistoryItem> &history, bool loadedAndSorted)
 {
-    m_history = history;
+    QList<HistoryItem> sortedHistory = history;
 
     // verify that it is sorted by date
     if (!loadedAndSorted)
-        qSort(m_history.begin(), m_history.end());
+        qSort(sortedHistory.begin(), sortedHistory.end());
+
+    // oldest first: the last visit of an url replaces the older ones
+    m_history.clear();
+    for (int i = sortedHistory.count() - 1; i >= 0; --i)
+        m_history.prepend(sortedHistory.at(i));
+
+    // there were duplicates: rewrite the file without them, too
+    const bool hadDuplicates = (m_history.count() != sortedHistory.count());
 
     checkForExpired();
 
-    if (loadedAndSorted)
+    if (loadedAndSorted && !hadDuplicates)
     {
-        m_lastSavedUrl = m_history.value(0).url;
+        m_lastSavedSerial = m_history.lastSerial();
     }
     else
     {
-        m_lastSavedUrl.clear();
+        m_lastSavedSerial = -1;
         m_saveTimer->changeOccurred();
     }
 
@@ -182,9 +1000,12 @@ void HistoryManager::checkForExpired()
     QDateTime now = QDateTime::currentDateTime();
     int nextTimeout = 0;
 
-    while (!m_history.isEmpty())
+    // expired items are the oldest ones: they go all at once
+    const int count = m_history.count();
+    int expiredCount = 0;
+    while (expiredCount < count)
     {
-        QDateTime checkForExpired = m_history.last().lastDateTimeVisit;
+        QDateTime checkForExpired = m_history.lastDateTimeVisitAt(count - 1 - expiredCount);
         checkForExpired.setDate(checkForExpired.date().addDays(m_historyLimit));
         if (now.daysTo(checkForExpired) > 7)
         {
@@ -197,12 +1018,12 @@ void HistoryManager::checkForExpired()
         }
         if (nextTimeout > 0)
             break;
-        HistoryItem item = m_history.takeLast();
-        // remove from saved file also
-        m_lastSavedUrl.clear();
-        emit entryRemoved(item);
+        expiredCount++;
     }
 
+    if (expiredCount > 0)
+        removeHistoryRows(count - expiredCount, expiredCount);
+
     if (nextTimeout > 0)
         QTimer::singleShot(nextTimeout * 1000, this, SLOT(checkForExpired()));
 }
@@ -210,55 +1031,177 @@ void HistoryManager::checkForExpired()
 
 void HistoryManager::removeHistoryEntry(const KUrl &url, const QString &title)
 {
-    HistoryItem item;
-    for (int i = 0; i < m_history.count(); ++i)
+    QString urlString = url.toString();
+    if (!m_history.contains(urlString))
+        urlString = url.url();
+
+    const int row = m_history.row(urlString);
+    if (row < 0)
+        return;
+
+    if (!title.isEmpty() && title != m_history.at(row).title)
+        return;
+
+    removeHistoryRows(row, 1);
+}
+
+
+void HistoryManager::removeHistoryRows(int row, int count)
+{
+    if (row < 0 || count <= 0 || row + count > m_history.count())
+        return;
+
+    // remove from saved file also
+    Q_FOREACH(const HistoryItem & item, takeHistoryRows(row, count))
     {
-        if (url == m_history.at(i).url
-                && (title.isEmpty() || title == m_history.at(i).title))
-        {
-            item = m_history.at(i);
-            m_lastSavedUrl.clear();
-            m_history.removeOne(item);
-            emit entryRemoved(item);
-            break;
-        }
+        m_removedUrls << item.url;
+        emit entryRemoved(item);
     }
 }
 
 
-QList<HistoryItem> HistoryManager::find(const QString &text)
+QList<HistoryItem> HistoryManager::takeHistoryRows(int row, int count)
 {
-    QList<HistoryItem> list;
+    const int lastRow = row + count - 1;
+
+    emit entriesAboutToBeRemoved(row, lastRow);
 
-    QStringList urlKeys = m_historyFilterModel->keys();
-    Q_FOREACH(const QString & url, urlKeys)
+    // from the last one: the rows before stay the same
+    QList<HistoryItem> items;
+    for (int i = lastRow; i >= row; --i)
     {
-        int index = m_historyFilterModel->historyLocation(url);
-        HistoryItem item = m_history.at(index);
+        const QString url = m_history.at(i).url;
+        items << m_history.take(url);
+    }
 
-        QStringList words = text.split(' ');
-        bool matches = true;
-        Q_FOREACH(const QString & word, words)
-        {
-            if (!url.contains(word, Qt::CaseInsensitive)
-                    && !item.title.contains(word, Qt::CaseInsensitive))
-            {
-                matches = false;
-                break;
-            }
-        }
-        if (matches)
-            list << item;
+    emit entriesRemoved(row, lastRow);
+
+    return items;
+}
+
+
+int HistoryManager::removeHistoryEntries(const HistoryItemFilter &filter)
+{
+    QList<int> rows;
+    for (int row = 0; row < m_history.count(); ++row)
+    {
+        if (filter.matches(m_history.at(row)))
+            rows << row;
     }
 
-    return list;
+    if (rows.isEmpty())
+        return 0;
+
+    // Scattered rows are removed a contiguous run at a time, from the last
+    // one: the rows before a run stay the same, and views just lose its rows
+    int last = rows.count() - 1;
+    while (last >= 0)
+    {
+        int first = last;
+        while (first > 0 && rows.at(first - 1) == rows.at(first) - 1)
+            --first;
+
+        takeHistoryRows(rows.at(first), last - first + 1);
+        last = first - 1;
+    }
+
+    compactAfterRemoval();
+    return rows.count();
+}
+
+
+int HistoryManager::removeHistoryEntriesBetween(const QDateTime &from, const QDateTime &to)
+{
+    // items are sorted by last visit: they are all in a block
+    const int firstRow = to.isValid() ? firstRowBefore(to) : 0;
+    const int lastRow = firstRowBefore(from) - 1;
+    if (lastRow < firstRow)
+        return 0;
+
+    const int count = lastRow - firstRow + 1;
+    takeHistoryRows(firstRow, count);
+
+    compactAfterRemoval();
+    return count;
+}
+
+
+class HostFilter : public HistoryItemFilter
+{
+public:
+    explicit HostFilter(const QString &host)
+        : m_host(host.toLower())
+        , m_subdomains(QL1C('.') + m_host)
+    {
+    }
+
+    bool matches(const HistoryItem &item) const
+    {
+        // most urls are out without being parsed
+        if (!item.url.contains(m_host, Qt::CaseInsensitive))
+            return false;
+
+        const QString host = QUrl(item.url).host().toLower();
+        return host == m_host || host.endsWith(m_subdomains);
+    }
+
+private:
+    QString m_host;
+    QString m_subdomains;
+};
+
+
+int HistoryManager::removeHistoryEntriesOfHost(const QString &host)
+{
+    if (host.isEmpty())
+        return 0;
+
+    return removeHistoryEntries(HostFilter(host));
+}
+
+
+int HistoryManager::firstRowBefore(const QDateTime &dateTime) const
+{
+    int first = 0;
+    int last = m_history.count();
+    while (first < last)
+    {
+        const int middle = first + (last - first) / 2;
+        if (m_history.lastDateTimeVisitAt(middle) < dateTime)
+            last = middle;
+        else
+            first = middle + 1;
+    }
+    return first;
+}
+
+
+void HistoryManager::compactAfterRemoval()
+{
+    // the whole history is written again, so removed urls are not left in the file
+    m_removedUrls.clear();
+    m_lastSavedSerial = -1;
+    m_saveTimer->changeOccurred();
+}
+
+
+QList<HistoryItem> HistoryManager::find(const QString &text)
+{
+    return m_historyIndex->find(text.split(' ', QString::SkipEmptyParts));
+}
+
+
+QList<HistoryItem> HistoryManager::findRelevant(const QString &text, int count, HistorySearch *search)
+{
+    return m_historyIndex->findRelevant(text.split(' ', QString::SkipEmptyParts), count, search);
 }
 
 
 void HistoryManager::clear()
 {
     m_history.clear();
-    m_lastSavedUrl.clear();
+    m_removedUrls.clear();
+    m_lastSavedSerial = -1;
     m_saveTimer->changeOccurred();
     m_saveTimer->saveIfNeccessary();
     historyReset();
@@ -295,17 +1238,44 @@ void HistoryManager::load()
 {
     loadSettings();
 
-    QString historyFilePath = KStandardDirs::locateLocal("appdata" , "history");
-    QFile historyFile(historyFilePath);
+    QFile historyFile(m_historyFile.filePath());
     if (!historyFile.exists())
         return;
+
+    QList<HistoryItem> list;
+    if (m_historyFile.load(&list))
+    {
+        // one item per url, oldest first
+        m_history.clear();
+        Q_FOREACH(const HistoryItem & item, list)
+        {
+            m_history.prepend(item);
+        }
+        m_lastSavedSerial = m_history.lastSerial();
+
+        // Loading reads every record, dead ones too: a file with too many of them
+        // (eg: left by a session that crashed before compacting it) is written again
+        const int deadRecords = m_historyFile.recordCount() - m_history.count();
+        if (deadRecords >= minDeadRecordsToCompact && deadRecords > m_history.count())
+        {
+            m_lastSavedSerial = -1;
+            m_saveTimer->changeOccurred();
+        }
+
+        checkForExpired();
+
+        emit historyReset();
+        return;
+    }
+
+    // Not an history file of ours: load it as one of rekonq <= 1.0,
+    // a QDataStream of (versioned) items, and convert it on next save
     if (!historyFile.open(QFile::ReadOnly))
     {
         kDebug() << "Unable to open history file" << historyFile.fileName();
         return;
     }
 
-    QList<HistoryItem> list;
     QDataStream in(&historyFile);
     // Double check that the history file is sorted as it is read in
     bool needToSort = false;
@@ -327,7 +1297,7 @@ void HistoryManager::load()
 
         switch (version)
         {
-        case HISTORY_VERSION:   // default case
+        case 25:                // this was history structure for rekonq <= 1.0
             stream >> item.url;
             stream >> item.firstDateTimeVisit;
             stream >> item.lastDateTimeVisit;
@@ -376,80 +1346,48 @@ void HistoryManager::load()
 
     setHistory(list, true);
 
-    // If we had to sort re-write the whole history sorted
-    if (needToSort)
-    {
-        m_lastSavedUrl.clear();
-        m_saveTimer->changeOccurred();
-    }
+    // write it again, in the new format
+    m_lastSavedSerial = -1;
+    m_saveTimer->changeOccurred();
 }
 
 
 void HistoryManager::save()
 {
-    bool saveAll = m_lastSavedUrl.isEmpty();
-    int first = m_history.count() - 1;
-    if (!saveAll)
-    {
-        // find the first one to save
-        for (int i = 0; i < m_history.count(); ++i)
-        {
-            if (m_history.at(i).url == m_lastSavedUrl)
-            {
-                first = i - 1;
-                break;
-            }
-        }
-    }
-    if (first == m_history.count() - 1)
-        saveAll = true;
+    FileWriter *writer = rApp->fileWriter();
 
-    QString historyFilePath = KStandardDirs::locateLocal("appdata" , "history");
-    QFile historyFile(historyFilePath);
+    // dead records in the file are dropped just when they are many, and more than the live ones
+    const QList<HistoryItem> items = m_history.itemsSince(m_lastSavedSerial);
+    const int liveRecords = m_history.count();
+    const int deadRecords = m_historyFile.recordCount() + items.count() + m_removedUrls.count() - liveRecords;
 
-    // When saving everything use a temporary file to prevent possible data loss.
-    QTemporaryFile tempFile;
-    tempFile.setAutoRemove(false);
-    bool open = false;
-    if (saveAll)
+    if (m_lastSavedSerial < 0 || (deadRecords >= minDeadRecordsToCompact && deadRecords > liveRecords))
     {
-        open = tempFile.open();
+        writer->replaceFile(m_historyFile.filePath(), m_historyFile.rewriteData(m_history.itemsSince(-1)));
     }
     else
     {
-        open = historyFile.open(QFile::Append);
+        // just the items visited since last save, and the removed urls, are appended
+        writer->appendToFile(m_historyFile.filePath(), m_historyFile.appendData(items, m_removedUrls));
     }
 
-    if (!open)
-    {
-        kDebug() << "Unable to open history file for saving"
-                 << (saveAll ? tempFile.fileName() : historyFile.fileName());
-        return;
-    }
+    m_lastSavedSerial = m_history.lastSerial();
+    m_removedUrls.clear();
+}
 
-    QDataStream out(saveAll ? &tempFile : &historyFile);
-    for (int i = first; i >= 0; --i)
-    {
-        QByteArray data;
-        QDataStream stream(&data, QIODevice::WriteOnly);
-        HistoryItem item = m_history.at(i);
-        stream << HISTORY_VERSION << item.url << item.firstDateTimeVisit << item.lastDateTimeVisit << item.title << item.visitCount;
-        out << data;
-    }
-    tempFile.close();
 
-    if (saveAll)
+void HistoryManager::fileWritten(const QString &filePath, bool ok)
+{
+    if (filePath != m_historyFile.filePath())
+        return;
+
+    if (!ok)
     {
-        if (historyFile.exists() && !historyFile.remove())
-        {
-            kDebug() << "History: error removing old history." << historyFile.errorString();
-        }
-        if (!tempFile.rename(historyFile.fileName()))
-        {
-            kDebug() << "History: error moving new history over old." << tempFile.errorString() << historyFile.fileName();
-        }
+        // the file may be broken at its end: write it again
+        m_lastSavedSerial = -1;
+        m_saveTimer->changeOccurred();
+        return;
     }
-    m_lastSavedUrl = m_history.value(0).url;
 
     emit historySaved();
 }
@@ -33,13 +33,20 @@
 // Rekonq Includes
 #include "rekonq_defines.h"
 
+// Local Includes
+#include "historyfile.h"
+
 // KDE Includes
 #include <KUrl>
 
 // Qt Includes
+#include <QByteArray>
 #include <QDateTime>
 #include <QHash>
+#include <QList>
 #include <QObject>
+#include <QStringList>
+#include <QVector>
 #include <QWebHistory>
 
 #include <math.h>
@@ -47,6 +54,7 @@
 // Forward Declarations
 class AutoSaver;
 class HistoryFilterModel;
+class HistoryManager;
 class HistoryTreeModel;
 
 class QWebHistory;
@@ -83,7 +91,13 @@ public:
 
     inline qreal relevance() const
     {
-        return log(visitCount) - log(lastDateTimeVisit.daysTo(QDateTime::currentDateTime()) + 1);
+        return relevance(QDate::currentDate());
+    }
+
+    // The same, on a day: it changes just once a day
+    inline qreal relevance(const QDate &day) const
+    {
+        return log(visitCount) - log(lastDateTimeVisit.date().daysTo(day) + 1);
     }
 
     // history is sorted in reverse
@@ -103,6 +117,256 @@ public:
 // ---------------------------------------------------------------------------------------------------------------
 
 
+/**
+ * The history items, most recently visited first, one per url.
+ *
+ * Items are stored in visit order in a vector of slots, indexed by url:
+ * a visit appends the item again and leaves a hole where it was, so visits,
+ * removals and url lookups are O(1). A Fenwick tree counting the items in the
+ * slots maps rows to slots (and back) in O(log n), and holes are compacted
+ * away when they outnumber the items.
+ *
+ * Slots are kept small, as histories can be huge: visits are epoch
+ * milliseconds, the scheme and host of the urls ("http://kde.org") are
+ * interned, and the rest of the urls and the titles are UTF-8 in a single
+ * string arena. The url index is an open addressing table of slots, with
+ * no copies of the urls. HistoryItems are built when asked for.
+ *
+ */
+class REKONQ_TESTS_EXPORT HistoryList
+{
+public:
+    HistoryList();
+
+    int count() const
+    {
+        return m_count;
+    }
+
+    bool isEmpty() const
+    {
+        return m_count == 0;
+    }
+
+    bool contains(const QString &url) const
+    {
+        return findSlot(url) != -1;
+    }
+
+    // row 0 is the most recently visited item
+    HistoryItem at(int row) const;
+    HistoryItem last() const;
+
+    // The same, without building the item
+    QDateTime lastDateTimeVisitAt(int row) const;
+
+    // the row of the item with this url, or -1
+    int row(const QString &url) const;
+
+    // Add the item as the most recent one, replacing the item with the same url
+    void prepend(const HistoryItem &item);
+
+    HistoryItem take(const QString &url);
+    HistoryItem takeLast();
+
+    void clear();
+
+    // every item, most recent first
+    QList<HistoryItem> toList() const;
+
+    // Every item gets a serial number, increasing with the prepends:
+    // the ones added since a serial are returned oldest first
+    int lastSerial() const
+    {
+        return m_serial;
+    }
+    QList<HistoryItem> itemsSince(int serial) const;
+
+    int serialAt(int row) const;
+
+    // the item with this serial, or an empty one when it is no more there
+    HistoryItem itemWithSerial(int serial) const;
+
+private:
+    struct Slot
+    {
+        // epoch milliseconds, 0 when invalid
+        qint64 firstVisit;
+        qint64 lastVisit;
+        int serial;
+        int visitCount;
+
+        // url is the prefix, and then the path (in the arena). Holes have no prefix (-1)
+        int prefix;
+        int path;
+        int pathLength;
+        int title;
+        int titleLength;
+        uint hash;
+    };
+
+    // an url, split as it is stored
+    struct Key
+    {
+        int prefix;
+        QByteArray path;
+        uint hash;
+    };
+
+    // slot of the n-th (0 is the oldest) item, and number of items before a slot
+    int slot(int n) const;
+    int itemsBefore(int slot) const;
+
+    void addToTree(int slot, int delta);
+    void makeHole(int slot);
+
+    // drop the holes, when they are more than the items
+    void compact();
+
+    HistoryItem item(int slot) const;
+    QString url(int slot) const;
+
+    // the key of url. Its prefix is -1 when unknown
+    Key key(const QString &url) const;
+    int internPrefix(const QString &prefix);
+
+    // the slot of the item with this url, or -1
+    int findSlot(const QString &url) const;
+    int findSlot(const Key &key) const;
+    void insertSlot(int slot, uint hash);
+    void removeSlot(int slot);
+    void rehash(int buckets);
+
+    int appendString(const QByteArray &string);
+    bool isString(int offset, int length, const QByteArray &string) const;
+
+    QVector<Slot> m_slots;
+
+    // Fenwick tree (1-based) of the items per slot
+    QVector<int> m_tree;
+
+    // url --> slot, with linear probing. -1 when empty, -2 when removed
+    QVector<int> m_buckets;
+    int m_usedBuckets;
+
+    QVector<QString> m_prefixes;
+    QHash<QString, int> m_prefixIds;
+
+    QByteArray m_strings;
+
+    int m_count;
+    int m_serial;
+};
+
+
+// ---------------------------------------------------------------------------------------------------------------
+
+
+/**
+ * The history items found for some words by HistoryManager::findRelevant().
+ * Kept by who looks for a growing text (eg: while it is typed), the next
+ * search just checks these items, instead of the whole history.
+ *
+ */
+class HistorySearch
+{
+public:
+    HistorySearch()
+        : m_revision(-1)
+    {}
+
+private:
+    friend class HistoryIndex;
+
+    QStringList m_words;
+    QVector<int> m_ids;
+
+    // of the HistoryIndex, when the ids were found
+    int m_revision;
+};
+
+
+// ---------------------------------------------------------------------------------------------------------------
+
+
+/**
+ * Inverted trigram index of the history items, used by HistoryManager::find.
+ *
+ * Every (lowercase) trigram of an item url and title has the sorted list of the
+ * items having it: a query is the intersection of the lists of its words trigrams,
+ * checked then against the words. Items get increasing ids as they are added,
+ * removed ones are just dead (and dropped when they are too many), so updates
+ * never touch the existing lists. Ids just keep the item serial in HistoryList:
+ * urls and titles are not copied, and items no more there are the dead ones.
+ *
+ * Items relevance (their frecency) is cached too: computed on visit, and again
+ * just when asked for on another day.
+ *
+ */
+class REKONQ_TESTS_EXPORT HistoryIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit HistoryIndex(HistoryManager *manager);
+
+    // items containing every word (case insensitive), in their url or title. Most recent first
+    QList<HistoryItem> find(const QStringList &words) const;
+
+    // The count most relevant of them, most relevant first.
+    // With a search, the items it found are refined when they can be
+    QList<HistoryItem> findRelevant(const QStringList &words, int count, HistorySearch *search = 0) const;
+
+public Q_SLOTS:
+    void addItem(const HistoryItem &item);
+    void itemsRemoved(int firstRow, int lastRow);
+
+    // index again the whole history
+    void reset();
+
+private:
+    struct Frecency
+    {
+        qreal score;
+        int day;
+    };
+
+    // ids of the items containing every word, ascending
+    QVector<int> findIds(const QStringList &words) const;
+
+    qreal frecency(int id, const QDate &today) const;
+
+    // every item containing words contains searchWords too
+    static bool isRefinement(const QStringList &words, const QStringList &searchWords);
+
+    void addTrigrams(int id, const HistoryItem &item);
+    void compact();
+
+    // the item with this id, or an empty one when it is dead
+    HistoryItem item(int id) const;
+
+    static bool matches(const HistoryItem &item, const QStringList &words);
+
+    HistoryManager *m_manager;
+
+    // item id --> serial of the item in the history, ascending
+    QVector<int> m_serials;
+    int m_deadCount;
+
+    // grows when ids are added, removed or given again: searches for
+    // older ones can miss some, or have dead ones
+    int m_revision;
+
+    // item id --> relevance, and the (julian) day it is for
+    mutable QVector<Frecency> m_frecencies;
+
+    QHash<quint64, QVector<int> > m_postings;
+};
+
+
+// ---------------------------------------------------------------------------------------------------------------
+
+
 class TabHistory
 {
 public:
@@ -140,6 +404,22 @@ public:
 // ---------------------------------------------------------------------------------------------------------------
 
 
+/**
+ * The items to remove, for HistoryManager::removeHistoryEntries()
+ *
+ */
+class REKONQ_TESTS_EXPORT HistoryItemFilter
+{
+public:
+    virtual ~HistoryItemFilter() {}
+
+    virtual bool matches(const HistoryItem &item) const = 0;
+};
+
+
+// ---------------------------------------------------------------------------------------------------------------
+
+
 /**
  * THE History Manager:
  * It manages rekonq history
@@ -157,9 +437,25 @@ public:
     void addHistoryEntry(const KUrl &url, const QString &title);
     void removeHistoryEntry(const KUrl &url, const QString &title = QString());
 
+    // remove count items, from row (0 is the most recent one) on
+    void removeHistoryRows(int row, int count);
+
+    // Bulk removals: matching items go in one pass, with one model change per run of
+    // contiguous rows, and the history file is written again without them. They return how many went
+    int removeHistoryEntries(const HistoryItemFilter &filter);
+
+    // last visited from from on, and before to (when valid)
+    int removeHistoryEntriesBetween(const QDateTime &from, const QDateTime &to = QDateTime());
+
+    // from the host, or its subdomains
+    int removeHistoryEntriesOfHost(const QString &host);
+
     QList<HistoryItem> find(const QString &text);
 
-    QList<HistoryItem> history() const
+    // the count most relevant items found, most relevant first
+    QList<HistoryItem> findRelevant(const QString &text, int count, HistorySearch *search = 0);
+
+    const HistoryList &history() const
     {
         return m_history;
     };
@@ -180,6 +476,11 @@ Q_SIGNALS:
     void entryAdded(const HistoryItem &item);
     void entryRemoved(const HistoryItem &item);
 
+    // Rows of history(), removed at once. entryRemoved() follows for every item,
+    // but for bulk removals: they save the whole history once, instead
+    void entriesAboutToBeRemoved(int firstRow, int lastRow);
+    void entriesRemoved(int firstRow, int lastRow);
+
     void historySaved();
 
 public Q_SLOTS:
@@ -190,14 +491,33 @@ private Q_SLOTS:
     void save();
     void checkForExpired();
 
+    void fileWritten(const QString &filePath, bool ok);
+
 private:
     void load();
 
+    // remove the rows, telling the models and the index about them
+    QList<HistoryItem> takeHistoryRows(int row, int count);
+
+    // the first row last visited before dateTime
+    int firstRowBefore(const QDateTime &dateTime) const;
+
+    // removed items are dropped from the file too, with a rewrite
+    void compactAfterRemoval();
+
     AutoSaver *m_saveTimer;
     int m_historyLimit;
-    QList<HistoryItem> m_history;
-    QString m_lastSavedUrl;
+    HistoryList m_history;
+
+    // serial of the last item in the history file, or -1 when it has to be rewritten
+    int m_lastSavedSerial;
+
+    HistoryFile m_historyFile;
+
+    // urls removed since last save
+    QStringList m_removedUrls;
 
+    HistoryIndex *m_historyIndex;
     HistoryFilterModel *m_historyFilterModel;
     HistoryTreeModel *m_historyTreeModel;
 };
@@ -66,8 +66,9 @@ HistoryModel::HistoryModel(HistoryManager *history, QObject *parent)
 {
     Q_ASSERT(m_historyManager);
     connect(m_historyManager, SIGNAL(historyReset()), this, SLOT(historyReset()));
-    connect(m_historyManager, SIGNAL(entryRemoved(HistoryItem)), this, SLOT(historyReset()));
     connect(m_historyManager, SIGNAL(entryAdded(HistoryItem)), this, SLOT(entryAdded()));
+    connect(m_historyManager, SIGNAL(entriesAboutToBeRemoved(int, int)), this, SLOT(entriesAboutToBeRemoved(int, int)));
+    connect(m_historyManager, SIGNAL(entriesRemoved(int, int)), this, SLOT(entriesRemoved()));
 }
 
 
@@ -84,6 +85,18 @@ void HistoryModel::entryAdded()
 }
 
 
+void HistoryModel::entriesAboutToBeRemoved(int firstRow, int lastRow)
+{
+    beginRemoveRows(QModelIndex(), firstRow, lastRow);
+}
+
+
+void HistoryModel::entriesRemoved()
+{
+    endRemoveRows();
+}
+
+
 QVariant HistoryModel::headerData(int section, Qt::Orientation orientation, int role) const
 {
     if (orientation == Qt::Horizontal
@@ -101,11 +114,11 @@ QVariant HistoryModel::headerData(int section, Qt::Orientation orientation, int
 
 QVariant HistoryModel::data(const QModelIndex &index, int role) const
 {
-    QList<HistoryItem> lst = m_historyManager->history();
-    if (index.row() < 0 || index.row() >= lst.size())
+    const HistoryList &history = m_historyManager->history();
+    if (index.row() < 0 || index.row() >= history.count())
         return QVariant();
 
-    const HistoryItem &item = lst.at(index.row());
+    const HistoryItem &item = history.at(index.row());
     switch (role)
     {
     case DateTimeRole:
@@ -178,17 +191,11 @@ int HistoryModel::rowCount(const QModelIndex &parent) const
 
 bool HistoryModel::removeRows(int row, int count, const QModelIndex &parent)
 {
-    if (parent.isValid())
+    if (parent.isValid() || row < 0 || count <= 0 || row + count > rowCount())
         return false;
-    int lastRow = row + count - 1;
-    beginRemoveRows(parent, row, lastRow);
-    QList<HistoryItem> lst = m_historyManager->history();
-    for (int i = lastRow; i >= row; --i)
-        lst.removeAt(i);
-    disconnect(m_historyManager, SIGNAL(historyReset()), this, SLOT(historyReset()));
-    m_historyManager->setHistory(lst);
-    connect(m_historyManager, SIGNAL(historyReset()), this, SLOT(historyReset()));
-    endRemoveRows();
+
+    // rows are removed by the manager signals
+    m_historyManager->removeHistoryRows(row, count);
     return true;
 }
 
@@ -198,18 +205,36 @@ bool HistoryModel::removeRows(int row, int count, const QModelIndex &parent)
 
 HistoryFilterModel::HistoryFilterModel(QAbstractItemModel *sourceModel, QObject *parent)
     : QAbstractProxyModel(parent)
+    , m_historyManager(0)
+    , m_shift(0)
     , m_loaded(false)
+    , m_removedFirst(0)
+    , m_removedCount(0)
 {
     setSourceModel(sourceModel);
 }
 
 
+bool HistoryFilterModel::historyContains(const QString &url) const
+{
+    return m_historyManager->historyContains(url);
+}
+
+
+QList<QString> HistoryFilterModel::keys() const
+{
+    QList<QString> urls;
+    Q_FOREACH(const HistoryItem & item, m_historyManager->history().toList())
+    {
+        urls << item.url;
+    }
+    return urls;
+}
+
+
 int HistoryFilterModel::historyLocation(const QString &url) const
 {
-    load();
-    if (!m_historyHash.contains(url))
-        return 0;
-    return sourceModel()->rowCount() - m_historyHash.value(url);
+    return qMax(m_historyManager->history().row(url), 0);
 }
 
 
@@ -228,12 +253,17 @@ void HistoryFilterModel::setSourceModel(QAbstractItemModel *newSourceModel)
                    this, SLOT(dataChanged(QModelIndex, QModelIndex)));
         disconnect(sourceModel(), SIGNAL(rowsInserted(QModelIndex, int, int)),
                    this, SLOT(sourceRowsInserted(QModelIndex, int, int)));
+        disconnect(sourceModel(), SIGNAL(rowsAboutToBeRemoved(QModelIndex, int, int)),
+                   this, SLOT(sourceRowsAboutToBeRemoved(QModelIndex, int, int)));
         disconnect(sourceModel(), SIGNAL(rowsRemoved(QModelIndex, int, int)),
                    this, SLOT(sourceRowsRemoved(QModelIndex, int, int)));
     }
 
     QAbstractProxyModel::setSourceModel(newSourceModel);
 
+    HistoryModel *historyModel = qobject_cast<HistoryModel *>(newSourceModel);
+    m_historyManager = historyModel ? historyModel->historyManager() : 0;
+
     if (sourceModel())
     {
         m_loaded = false;
@@ -242,6 +272,8 @@ void HistoryFilterModel::setSourceModel(QAbstractItemModel *newSourceModel)
                 this, SLOT(sourceDataChanged(QModelIndex, QModelIndex)));
         connect(sourceModel(), SIGNAL(rowsInserted(QModelIndex, int, int)),
                 this, SLOT(sourceRowsInserted(QModelIndex, int, int)));
+        connect(sourceModel(), SIGNAL(rowsAboutToBeRemoved(QModelIndex, int, int)),
+                this, SLOT(sourceRowsAboutToBeRemoved(QModelIndex, int, int)));
         connect(sourceModel(), SIGNAL(rowsRemoved(QModelIndex, int, int)),
                 this, SLOT(sourceRowsRemoved(QModelIndex, int, int)));
     }
@@ -272,7 +304,7 @@ int HistoryFilterModel::rowCount(const QModelIndex &parent) const
     load();
     if (parent.isValid())
         return 0;
-    return m_historyHash.count();
+    return m_sourceRow.count();
 }
 
 
@@ -285,37 +317,25 @@ int HistoryFilterModel::columnCount(const QModelIndex &parent) const
 QModelIndex HistoryFilterModel::mapToSource(const QModelIndex &proxyIndex) const
 {
     load();
-    int sourceRow = sourceModel()->rowCount() - proxyIndex.internalId();
-    return sourceModel()->index(sourceRow, proxyIndex.column());
+    if (!proxyIndex.isValid())
+        return QModelIndex();
+
+    return sourceModel()->index(m_sourceRow.at(proxyIndex.row()) + m_shift, proxyIndex.column());
 }
 
 
 QModelIndex HistoryFilterModel::mapFromSource(const QModelIndex &sourceIndex) const
 {
     load();
-    QString url = sourceIndex.data(HistoryModel::UrlStringRole).toString();
-    if (!m_historyHash.contains(url))
+    if (!sourceIndex.isValid())
         return QModelIndex();
 
-    // This can be done in a binary search, but we can't use qBinary find
-    // because it can't take: qBinaryFind(m_sourceRow.end(), m_sourceRow.begin(), v);
-    // so if this is a performance bottlneck then convert to binary search, until then
-    // the cleaner/easier to read code wins the day.
-    int realRow = -1;
-    int sourceModelRow = sourceModel()->rowCount() - sourceIndex.row();
-
-    for (int i = 0; i < m_sourceRow.count(); ++i)
-    {
-        if (m_sourceRow.at(i) == sourceModelRow)
-        {
-            realRow = i;
-            break;
-        }
-    }
-    if (realRow == -1)
+    // filtered out duplicates have no row
+    int realRow = lowerBound(sourceIndex.row());
+    if (realRow == m_sourceRow.count() || m_sourceRow.at(realRow) + m_shift != sourceIndex.row())
         return QModelIndex();
 
-    return createIndex(realRow, sourceIndex.column(), sourceModel()->rowCount() - sourceIndex.row());
+    return createIndex(realRow, sourceIndex.column());
 }
 
 
@@ -326,7 +346,7 @@ QModelIndex HistoryFilterModel::index(int row, int column, const QModelIndex &pa
             || column < 0 || column >= columnCount(parent))
         return QModelIndex();
 
-    return createIndex(row, column, m_sourceRow[row]);
+    return createIndex(row, column);
 }
 
 
@@ -341,22 +361,24 @@ void HistoryFilterModel::load() const
     if (m_loaded)
         return;
     m_sourceRow.clear();
-    m_historyHash.clear();
-    m_historyHash.reserve(sourceModel()->rowCount());
-    for (int i = 0; i < sourceModel()->rowCount(); ++i)
-    {
-        QModelIndex idx = sourceModel()->index(i, 0);
-        QString url = idx.data(HistoryModel::UrlStringRole).toString();
-        if (!m_historyHash.contains(url))
-        {
-            m_sourceRow.append(sourceModel()->rowCount() - i);
-            m_historyHash[url] = sourceModel()->rowCount() - i;
-        }
-    }
+    m_shift = 0;
+
+    // the source has a row per url: nothing to filter out
+    const int rows = sourceModel()->rowCount();
+    m_sourceRow.reserve(rows);
+    for (int i = 0; i < rows; ++i)
+        m_sourceRow.append(i);
     m_loaded = true;
 }
 
 
+int HistoryFilterModel::lowerBound(int sourceRow) const
+{
+    return qLowerBound(m_sourceRow.constBegin(), m_sourceRow.constEnd(), sourceRow - m_shift)
+           - m_sourceRow.constBegin();
+}
+
+
 void HistoryFilterModel::sourceRowsInserted(const QModelIndex &parent, int start, int end)
 {
     Q_UNUSED(end);
@@ -370,29 +392,48 @@ void HistoryFilterModel::sourceRowsInserted(const QModelIndex &parent, int start
     if (!m_loaded)
         return;
 
-    QModelIndex idx = sourceModel()->index(start, 0, parent);
-    QString url = idx.data(HistoryModel::UrlStringRole).toString();
-    if (m_historyHash.contains(url))
-    {
-        int sourceRow = sourceModel()->rowCount() - m_historyHash[url];
-        int realRow = mapFromSource(sourceModel()->index(sourceRow, 0)).row();
-        beginRemoveRows(QModelIndex(), realRow, realRow);
-        m_sourceRow.removeAt(realRow);
-        m_historyHash.remove(url);
-        endRemoveRows();
-    }
+    // every source row moved down by one. The previous visit of the url,
+    // if any, has been removed before (see HistoryManager::addHistoryEntry)
+    m_shift++;
+
     beginInsertRows(QModelIndex(), 0, 0);
-    m_historyHash.insert(url, sourceModel()->rowCount() - start);
-    m_sourceRow.insert(0, sourceModel()->rowCount());
+    m_sourceRow.prepend(start - m_shift);
     endInsertRows();
 }
 
 
-void HistoryFilterModel::sourceRowsRemoved(const QModelIndex &, int start, int end)
+void HistoryFilterModel::sourceRowsAboutToBeRemoved(const QModelIndex &parent, int start, int end)
 {
-    Q_UNUSED(start);
-    Q_UNUSED(end);
-    sourceReset();
+    m_removedFirst = 0;
+    m_removedCount = 0;
+
+    if (!m_loaded || parent.isValid())
+        return;
+
+    m_removedFirst = lowerBound(start);
+    m_removedCount = lowerBound(end + 1) - m_removedFirst;
+    if (m_removedCount == 0)
+        return;
+
+    beginRemoveRows(QModelIndex(), m_removedFirst, m_removedFirst + m_removedCount - 1);
+}
+
+
+void HistoryFilterModel::sourceRowsRemoved(const QModelIndex &parent, int start, int end)
+{
+    if (!m_loaded || parent.isValid())
+        return;
+
+    QList<int>::iterator first = m_sourceRow.begin() + m_removedFirst;
+    m_sourceRow.erase(first, first + m_removedCount);
+
+    // the older rows moved up by the removed ones
+    const int count = end - start + 1;
+    for (int i = m_removedFirst; i < m_sourceRow.count(); ++i)
+        m_sourceRow[i] -= count;
+
+    if (m_removedCount > 0)
+        endRemoveRows();
 }
 
 
@@ -404,21 +445,11 @@ bool HistoryFilterModel::removeRows(int row, int count, const QModelIndex &paren
 {
     if (row < 0 || count <= 0 || row + count > rowCount(parent) || parent.isValid())
         return false;
-    int lastRow = row + count - 1;
-    disconnect(sourceModel(), SIGNAL(rowsRemoved(QModelIndex, int, int)),
-               this, SLOT(sourceRowsRemoved(QModelIndex, int, int)));
-    beginRemoveRows(parent, row, lastRow);
-    int oldCount = rowCount();
-    int start = sourceModel()->rowCount() - m_sourceRow.value(row);
-    int end = sourceModel()->rowCount() - m_sourceRow.value(lastRow);
-    sourceModel()->removeRows(start, end - start + 1);
-    endRemoveRows();
-    connect(sourceModel(), SIGNAL(rowsRemoved(QModelIndex, int, int)),
-            this, SLOT(sourceRowsRemoved(QModelIndex, int, int)));
-    m_loaded = false;
-    if (oldCount - count != rowCount())
-        reset();
-    return true;
+
+    // proxy rows follow the source ones, as they go
+    int start = m_sourceRow.at(row) + m_shift;
+    int end = m_sourceRow.at(row + count - 1) + m_shift;
+    return sourceModel()->removeRows(start, end - start + 1);
 }
 
 
@@ -440,42 +471,35 @@ QVariant HistoryTreeModel::headerData(int section, Qt::Orientation orientation,
 
 QVariant HistoryTreeModel::data(const QModelIndex &index, int role) const
 {
-    if (role == Qt::EditRole || role == Qt::DisplayRole)
+    if (index.isValid() && index.internalId() == 0)
     {
-        int start = index.internalId();
-        if (start == 0)
+        const Day &day = m_days.at(index.row());
+
+        if (role == Qt::EditRole || role == Qt::DisplayRole)
         {
-            int offset = sourceDateRow(index.row());
             if (index.column() == 0)
             {
-                QModelIndex idx = sourceModel()->index(offset, 0);
-                QDate date = idx.data(HistoryModel::DateRole).toDate();
-                if (date == QDate::currentDate())
+                if (day.date == QDate::currentDate())
                     return i18n("Earlier Today");
-                return date.toString(QL1S("dddd, MMMM d, yyyy"));
+                return day.date.toString(QL1S("dddd, MMMM d, yyyy"));
             }
             if (index.column() == 1)
             {
-                return i18np("1 item", "%1 items", rowCount(index.sibling(index.row(), 0)));
+                return i18np("1 item", "%1 items", day.count);
             }
         }
-    }
 
-    if (role == Qt::DecorationRole && index.column() == 0 && !index.parent().isValid())
-        return KIcon("view-history");
+        if (role == Qt::DecorationRole && index.column() == 0)
+            return KIcon("view-history");
 
-    if (role == HistoryModel::DateRole && index.column() == 0 && index.internalId() == 0)
-    {
-        int offset = sourceDateRow(index.row());
-        QModelIndex idx = sourceModel()->index(offset, 0);
-        return idx.data(HistoryModel::DateRole);
-    }
+        if (role == HistoryModel::DateRole && index.column() == 0)
+            return day.date;
 
-    if (role == HistoryModel::FirstDateTimeVisitRole && index.column() == 0 && index.internalId() == 0)
-    {
-        int offset = sourceDateRow(index.row());
-        QModelIndex idx = sourceModel()->index(offset, 0);
-        return idx.data(HistoryModel::FirstDateTimeVisitRole);
+        if (role == HistoryModel::FirstDateTimeVisitRole && index.column() == 0)
+        {
+            QModelIndex idx = sourceModel()->index(day.sourceRow, 0);
+            return idx.data(HistoryModel::FirstDateTimeVisitRole);
+        }
     }
 
     return QAbstractProxyModel::data(index, role);
@@ -490,57 +514,40 @@ int HistoryTreeModel::columnCount(const QModelIndex &parent) const
 
 int HistoryTreeModel::rowCount(const QModelIndex &parent) const
 {
-    if (parent.internalId() != 0
-            || parent.column() > 0
-            || !sourceModel())
+    if (parent.column() > 0 || !sourceModel())
         return 0;
 
     // row count OF dates
     if (!parent.isValid())
-    {
-        if (!m_sourceRowCache.isEmpty())
-            return m_sourceRowCache.count();
-        QDate currentDate;
-        int rows = 0;
-        int totalRows = sourceModel()->rowCount();
+        return m_days.count();
 
-        for (int i = 0; i < totalRows; ++i)
-        {
-            QDate rowDate = sourceModel()->index(i, 0).data(HistoryModel::DateRole).toDate();
-            if (rowDate != currentDate)
-            {
-                m_sourceRowCache.append(i);
-                currentDate = rowDate;
-                ++rows;
-            }
-        }
-        Q_ASSERT(m_sourceRowCache.count() == rows);
-        return rows;
-    }
+    if (parent.internalId() != 0)
+        return 0;
 
-    // row count FOR a date
-    int start = sourceDateRow(parent.row());
-    int end = sourceDateRow(parent.row() + 1);
-    return (end - start);
+    // row count FOR a date: its pages are there once fetched
+    const Day &day = m_days.at(parent.row());
+    return day.isFetched ? day.count : 0;
 }
 
 
-// Translate the top level date row into the offset where that date starts
-int HistoryTreeModel::sourceDateRow(int row) const
+bool HistoryTreeModel::canFetchMore(const QModelIndex &parent) const
 {
-    if (row <= 0)
-        return 0;
+    if (!parent.isValid() || parent.internalId() != 0 || parent.column() > 0)
+        return false;
 
-    if (m_sourceRowCache.isEmpty())
-        rowCount(QModelIndex());
+    return !m_days.at(parent.row()).isFetched;
+}
 
-    if (row >= m_sourceRowCache.count())
-    {
-        if (!sourceModel())
-            return 0;
-        return sourceModel()->rowCount();
-    }
-    return m_sourceRowCache.at(row);
+
+void HistoryTreeModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent))
+        return;
+
+    Day &day = m_days[parent.row()];
+    beginInsertRows(parent, 0, day.count - 1);
+    day.isFetched = true;
+    endInsertRows();
 }
 
 
@@ -549,14 +556,13 @@ QModelIndex HistoryTreeModel::mapToSource(const QModelIndex &proxyIndex) const
     int offset = proxyIndex.internalId();
     if (offset == 0)
         return QModelIndex();
-    int startDateRow = sourceDateRow(offset - 1);
-    return sourceModel()->index(startDateRow + proxyIndex.row(), proxyIndex.column());
+    return sourceModel()->index(m_days.at(offset - 1).sourceRow + proxyIndex.row(), proxyIndex.column());
 }
 
 
 QModelIndex HistoryTreeModel::index(int row, int column, const QModelIndex &parent) const
 {
-    if (row < 0
+    if (row < 0 || row >= rowCount(parent)
             || column < 0 || column >= columnCount(parent)
             || parent.column() > 0)
         return QModelIndex();
@@ -601,7 +607,7 @@ bool HistoryTreeModel::removeRows(int row, int count, const QModelIndex &parent)
     if (parent.isValid())
     {
         // removing pages
-        int offset = sourceDateRow(parent.row());
+        int offset = m_days.at(parent.row()).sourceRow;
         return sourceModel()->removeRows(offset + row, count);
     }
     else
@@ -609,9 +615,8 @@ bool HistoryTreeModel::removeRows(int row, int count, const QModelIndex &parent)
         // removing whole dates
         for (int i = row + count - 1; i >= row; --i)
         {
-            QModelIndex dateParent = index(i, 0);
-            int offset = sourceDateRow(dateParent.row());
-            if (!sourceModel()->removeRows(offset, rowCount(dateParent)))
+            const Day day = m_days.at(i);
+            if (!sourceModel()->removeRows(day.sourceRow, day.count))
                 return false;
         }
     }
@@ -643,13 +648,14 @@ void HistoryTreeModel::setSourceModel(QAbstractItemModel *newSourceModel)
                 this, SLOT(sourceRowsRemoved(QModelIndex, int, int)));
     }
 
+    loadDays();
     reset();
 }
 
 
 void HistoryTreeModel::sourceReset()
 {
-    m_sourceRowCache.clear();
+    loadDays();
     reset();
 }
 
@@ -660,24 +666,42 @@ void HistoryTreeModel::sourceRowsInserted(const QModelIndex &parent, int start,
     Q_ASSERT(!parent.isValid());
     if (start != 0 || start != end)
     {
-        m_sourceRowCache.clear();
-        reset();
+        sourceReset();
         return;
     }
 
-    m_sourceRowCache.clear();
-    QModelIndex treeIndex = mapFromSource(sourceModel()->index(start, 0));
-    QModelIndex treeParent = treeIndex.parent();
-    if (rowCount(treeParent) == 1)
+    const QDate date = sourceDate(0);
+
+    // a page of a new day
+    if (m_days.isEmpty() || m_days.first().date != date)
     {
         beginInsertRows(QModelIndex(), 0, 0);
+        for (int i = 0; i < m_days.count(); ++i)
+            m_days[i].sourceRow++;
+
+        Day day;
+        day.date = date;
+        day.sourceRow = 0;
+        day.count = 1;
+        day.isFetched = false;
+        m_days.prepend(day);
         endInsertRows();
+        return;
     }
-    else
-    {
-        beginInsertRows(treeParent, treeIndex.row(), treeIndex.row());
+
+    // another page of today
+    const bool isFetched = m_days.first().isFetched;
+    if (isFetched)
+        beginInsertRows(index(0, 0), 0, 0);
+
+    for (int i = 1; i < m_days.count(); ++i)
+        m_days[i].sourceRow++;
+    m_days[0].count++;
+
+    if (isFetched)
         endInsertRows();
-    }
+
+    emit dataChanged(index(0, 1), index(0, 1));
 }
 
 
@@ -686,16 +710,11 @@ QModelIndex HistoryTreeModel::mapFromSource(const QModelIndex &sourceIndex) cons
     if (!sourceIndex.isValid())
         return QModelIndex();
 
-    if (m_sourceRowCache.isEmpty())
-        rowCount(QModelIndex());
-
-    QList<int>::iterator it;
-    it = qLowerBound(m_sourceRowCache.begin(), m_sourceRowCache.end(), sourceIndex.row());
-    if (*it != sourceIndex.row())
-        --it;
+    const int dateRow = dayRow(sourceIndex.row());
+    if (dateRow < 0 || !m_days.at(dateRow).isFetched)
+        return QModelIndex();
 
-    int dateRow = qMax(0, it - m_sourceRowCache.begin());
-    int row = sourceIndex.row() - m_sourceRowCache.at(dateRow);
+    int row = sourceIndex.row() - m_days.at(dateRow).sourceRow;
     return createIndex(row, sourceIndex.column(), dateRow + 1);
 }
 
@@ -704,41 +723,112 @@ void HistoryTreeModel::sourceRowsRemoved(const QModelIndex &parent, int start, i
 {
     Q_UNUSED(parent); // Avoid warnings when compiling release
     Q_ASSERT(!parent.isValid());
-    if (m_sourceRowCache.isEmpty())
-        return;
-    for (int i = end; i >= start;)
+
+    // from the last removed row back, a date at a time: the dates before are still good
+    int i = end;
+    while (i >= start)
     {
-        QList<int>::iterator it;
-        it = qLowerBound(m_sourceRowCache.begin(), m_sourceRowCache.end(), i);
-        // playing it safe
-        if (it == m_sourceRowCache.end())
+        const int row = dayRow(i);
+        if (row < 0)
         {
-            m_sourceRowCache.clear();
-            reset();
+            // playing it safe
+            sourceReset();
             return;
         }
 
-        if (*it != i)
-            --it;
-        int row = qMax(0, it - m_sourceRowCache.begin());
-        int offset = m_sourceRowCache[row];
-        QModelIndex dateParent = index(row, 0);
-        // If we can remove all the rows in the date do that and skip over them
-        int rc = rowCount(dateParent);
-        if (i - rc + 1 == offset && start <= i - rc + 1)
+        const int offset = m_days.at(row).sourceRow;
+        const int first = qMax(start, offset);
+        const int removed = i - first + 1;
+
+        if (removed == m_days.at(row).count)
         {
+            // the whole date
             beginRemoveRows(QModelIndex(), row, row);
-            m_sourceRowCache.removeAt(row);
-            i -= rc + 1;
+            m_days.remove(row);
+            for (int j = row; j < m_days.count(); ++j)
+                m_days[j].sourceRow -= removed;
+            endRemoveRows();
         }
         else
         {
-            beginRemoveRows(dateParent, i - offset, i - offset);
-            ++row;
-            --i;
+            const bool isFetched = m_days.at(row).isFetched;
+            if (isFetched)
+                beginRemoveRows(index(row, 0), first - offset, i - offset);
+
+            m_days[row].count -= removed;
+            for (int j = row + 1; j < m_days.count(); ++j)
+                m_days[j].sourceRow -= removed;
+
+            if (isFetched)
+                endRemoveRows();
+
+            emit dataChanged(index(row, 1), index(row, 1));
         }
-        for (int j = row; j < m_sourceRowCache.count(); ++j)
-            --m_sourceRowCache[j];
-        endRemoveRows();
+
+        i = first - 1;
     }
 }
+
+
+void HistoryTreeModel::loadDays()
+{
+    m_days.clear();
+    if (!sourceModel())
+        return;
+
+    // Pages are sorted by visit, most recent first: every date starts where the
+    // previous one ends, and ends is found by a binary search
+    const int totalRows = sourceModel()->rowCount();
+    int row = 0;
+    while (row < totalRows)
+    {
+        const QDate date = sourceDate(row);
+
+        int low = row + 1;
+        int high = totalRows;
+        while (low < high)
+        {
+            const int middle = (low + high) / 2;
+            if (sourceDate(middle) >= date)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+
+        Day day;
+        day.date = date;
+        day.sourceRow = row;
+        day.count = low - row;
+        day.isFetched = false;
+        m_days << day;
+
+        row = low;
+    }
+}
+
+
+int HistoryTreeModel::dayRow(int sourceRow) const
+{
+    // the last date starting at sourceRow, or before
+    int low = 0;
+    int high = m_days.count();
+    while (low < high)
+    {
+        const int middle = (low + high) / 2;
+        if (m_days.at(middle).sourceRow <= sourceRow)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    const int row = low - 1;
+    if (row < 0 || sourceRow >= m_days.at(row).sourceRow + m_days.at(row).count)
+        return -1;
+    return row;
+}
+
+
+QDate HistoryTreeModel::sourceDate(int sourceRow) const
+{
+    return sourceModel()->index(sourceRow, 0).data(HistoryModel::DateRole).toDate();
+}
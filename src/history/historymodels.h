@@ -37,7 +37,8 @@
 #include <KUrl>
 
 // Qt Includes
-#include <QHash>
+#include <QDate>
+#include <QVector>
 #include <QAbstractTableModel>
 #include <QAbstractProxyModel>
 
@@ -61,9 +62,16 @@ public:
 
     explicit HistoryModel(HistoryManager *history, QObject *parent = 0);
 
+    HistoryManager *historyManager() const
+    {
+        return m_historyManager;
+    }
+
 public Q_SLOTS:
     void historyReset();
     void entryAdded();
+    void entriesAboutToBeRemoved(int firstRow, int lastRow);
+    void entriesRemoved();
 
 public:
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
@@ -82,8 +90,11 @@ private:
 
 /**
  * Proxy model that will remove any duplicate entries.
- * Both m_sourceRow and m_historyHash store their offsets not from
- * the front of the list, but as offsets from the back.
+ * m_sourceRow stores the source rows less m_shift, the rows inserted at
+ * the front since they were loaded: an insertion at the front changes
+ * none of them, a removal just the ones after it.
+ * Source rows have an url each (see HistoryList), so removed rows just
+ * take their proxy rows away, and urls are looked for in the history.
  *
  */
 class REKONQ_TESTS_EXPORT HistoryFilterModel : public QAbstractProxyModel
@@ -93,18 +104,8 @@ class REKONQ_TESTS_EXPORT HistoryFilterModel : public QAbstractProxyModel
 public:
     explicit HistoryFilterModel(QAbstractItemModel *sourceModel, QObject *parent = 0);
 
-    inline bool historyContains(const QString &url) const
-    {
-        load();
-        return m_historyHash.contains(url);
-    }
-
-    inline QList<QString> keys() const
-    {
-        load();
-        return m_historyHash.keys();
-    }
-
+    bool historyContains(const QString &url) const;
+    QList<QString> keys() const;
     int historyLocation(const QString &url) const;
 
     QModelIndex mapFromSource(const QModelIndex &sourceIndex) const;
@@ -122,14 +123,24 @@ private Q_SLOTS:
     void sourceReset();
     void sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
     void sourceRowsInserted(const QModelIndex &parent, int start, int end);
-    void sourceRowsRemoved(const QModelIndex &, int, int);
+    void sourceRowsAboutToBeRemoved(const QModelIndex &parent, int start, int end);
+    void sourceRowsRemoved(const QModelIndex &parent, int start, int end);
 
 private:
     void load() const;
 
+    // the first proxy row whose source row is not less than sourceRow
+    int lowerBound(int sourceRow) const;
+
+    HistoryManager *m_historyManager;
+
     mutable QList<int> m_sourceRow;
-    mutable QHash<QString, int> m_historyHash;
+    mutable int m_shift;
     mutable bool m_loaded;
+
+    // the proxy rows going away, between rowsAboutToBeRemoved and rowsRemoved
+    int m_removedFirst;
+    int m_removedCount;
 };
 
 
@@ -140,6 +151,11 @@ private:
  * Proxy model for the history model that converts the list
  * into a tree, one top level node per day.
  *
+ * The days are found once (with a binary search for their ends, as pages
+ * are sorted by visit) and then kept up to date as pages are added and
+ * removed. The pages of a day are there just after fetchMore(), so just
+ * the expanded days are ever walked through.
+ *
  * Used in the HistoryDialog.
  *
  */
@@ -159,6 +175,8 @@ public:
     QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const;
     QModelIndex parent(const QModelIndex &index = QModelIndex()) const;
     bool hasChildren(const QModelIndex &parent = QModelIndex()) const;
+    bool canFetchMore(const QModelIndex &parent) const;
+    void fetchMore(const QModelIndex &parent);
     Qt::ItemFlags flags(const QModelIndex &index) const;
     bool removeRows(int row, int count, const QModelIndex &parent = QModelIndex());
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
@@ -171,8 +189,23 @@ private Q_SLOTS:
     void sourceRowsRemoved(const QModelIndex &parent, int start, int end);
 
 private:
-    int sourceDateRow(int row) const;
-    mutable QList<int> m_sourceRowCache;
+    struct Day
+    {
+        QDate date;
+        int sourceRow;
+        int count;
+        bool isFetched;
+    };
+
+    void loadDays();
+
+    // the row of the day with this source row, or -1
+    int dayRow(int sourceRow) const;
+
+    QDate sourceDate(int sourceRow) const;
+
+    // the top level rows, most recent first
+    QVector<Day> m_days;
 };
 
 
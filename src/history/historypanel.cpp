@@ -46,6 +46,7 @@
 #include <KMessageBox>
 
 // Qt Includes
+#include <QDateTime>
 #include <QHeaderView>
 
 
@@ -124,9 +125,14 @@ void HistoryPanel::openAll()
     if (!index.isValid())
         return;
 
+    // pages of a (never expanded) day are there once fetched
+    QAbstractItemModel *treeModel = panelTreeView()->model();
+    if (treeModel->canFetchMore(index))
+        treeModel->fetchMore(index);
+
     QList<KUrl> allChild;
 
-    for (int i = 0; i < index.model()->rowCount(index); i++)
+    for (int i = 0; i < treeModel->rowCount(index); i++)
         allChild << qVariantValue<KUrl>(index.child(i, 0).data(Qt::UserRole));
 
     if (allChild.length() > 8)
@@ -150,14 +156,12 @@ void HistoryPanel::deleteGroup()
     if (!index.isValid())
         return;
 
-    //Getting all URLs of sub items.
-    QList<KUrl> allChild;
-    for (int i = 0; i < index.model()->rowCount(index); i++)
-        allChild << qVariantValue<KUrl>(index.child(i, 0).data(Qt::UserRole));
-
-    for (int i = 0; i < allChild.length(); i++)
-        rApp->historyManager()->removeHistoryEntry(allChild.at(i));
+    // the whole day, at once
+    const QDate date = index.data(HistoryModel::DateRole).toDate();
+    if (!date.isValid())
+        return;
 
+    rApp->historyManager()->removeHistoryEntriesBetween(QDateTime(date), QDateTime(date.addDays(1)));
 }
 
 void HistoryPanel::setup()
@@ -192,11 +196,7 @@ void HistoryPanel::forgetSite()
     removedFolderIndex = index.row();
 
     QString site = qVariantValue< KUrl >(index.data(Qt::UserRole)).host();
-    QList<HistoryItem> toRemove = rApp->historyManager()->find(site);
-    for (int i = 0; i < toRemove.length(); i++)
-    {
-        rApp->historyManager()->removeHistoryEntry(KUrl(toRemove.at(i).url));
-    }
+    rApp->historyManager()->removeHistoryEntriesOfHost(site);
 
     QModelIndex expandItem = panelTreeView()->model()->index(removedFolderIndex, 0);
     if (expandItem.isValid())
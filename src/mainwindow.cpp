@@ -88,6 +88,7 @@
 
 
 // Qt Includes
+#include <QtCore/QDateTime>
 #include <QtCore/QTimer>
 
 #include <QtDBus/QDBusInterface>
@@ -1331,6 +1332,8 @@ void MainWindow::clearPrivateData()
     QWidget widget;
     clearWidget.setupUi(&widget);
     clearWidget.clearHistory->setChecked(ReKonfig::clearHistory());
+    clearWidget.clearHistoryRange->setCurrentIndex(ReKonfig::clearHistoryRange());
+    clearWidget.clearHistoryRange->setEnabled(ReKonfig::clearHistory());
     clearWidget.clearDownloads->setChecked(ReKonfig::clearDownloads());
     clearWidget.clearCookies->setChecked(ReKonfig::clearCookies());
     clearWidget.clearCachedPages->setChecked(ReKonfig::clearCachedPages());
@@ -1344,6 +1347,7 @@ void MainWindow::clearPrivateData()
     {
         //Save current state
         ReKonfig::setClearHistory(clearWidget.clearHistory->isChecked());
+        ReKonfig::setClearHistoryRange(ReKonfig::EnumClearHistoryRange::type(clearWidget.clearHistoryRange->currentIndex()));
         ReKonfig::setClearDownloads(clearWidget.clearDownloads->isChecked());
         ReKonfig::setClearCookies(clearWidget.clearDownloads->isChecked());
         ReKonfig::setClearCachedPages(clearWidget.clearCachedPages->isChecked());
@@ -1352,7 +1356,26 @@ void MainWindow::clearPrivateData()
 
         if (clearWidget.clearHistory->isChecked())
         {
-            rApp->historyManager()->clear();
+            const QDateTime now = QDateTime::currentDateTime();
+            switch (ReKonfig::clearHistoryRange())
+            {
+            case ReKonfig::EnumClearHistoryRange::LastHour:
+                rApp->historyManager()->removeHistoryEntriesBetween(now.addSecs(-3600));
+                break;
+            case ReKonfig::EnumClearHistoryRange::LastDay:
+                rApp->historyManager()->removeHistoryEntriesBetween(now.addDays(-1));
+                break;
+            case ReKonfig::EnumClearHistoryRange::LastWeek:
+                rApp->historyManager()->removeHistoryEntriesBetween(now.addDays(-7));
+                break;
+            case ReKonfig::EnumClearHistoryRange::LastFourWeeks:
+                rApp->historyManager()->removeHistoryEntriesBetween(now.addDays(-28));
+                break;
+            case ReKonfig::EnumClearHistoryRange::Everything:
+            default:
+                rApp->historyManager()->clear();
+                break;
+            }
         }
 
         if (clearWidget.clearDownloads->isChecked())
@@ -490,6 +490,9 @@ void NewTabPage::historyPage(const QString & filter)
         QModelIndex index = proxy->index(i, 0, QModelIndex());
         if (proxy->hasChildren(index))
         {
+            if (proxy->canFetchMore(index))
+                proxy->fetchMore(index);
+
             m_root.appendInside(markup(QL1S("h3")));
             m_root.lastChild().setPlainText(index.data().toString());
 
@@ -74,7 +74,7 @@ void PanelTreeView::mousePressEvent(QMouseEvent *event)
 
     if (event->button() == Qt::RightButton)
     {
-        if (model()->rowCount(index) == 0)
+        if (!model()->hasChildren(index))
         {
             // An empty group needs to be handle by the panels
             emit contextMenuItemRequested(event->pos());
@@ -100,7 +100,7 @@ void PanelTreeView::mouseReleaseEvent(QMouseEvent *event)
 
     else if (event->button() == Qt::LeftButton)
     {
-        if (model()->rowCount(index) == 0)
+        if (!model()->hasChildren(index))
             emit openUrl(qVariantValue< KUrl >(index.data(Qt::UserRole)));
         else
             setExpanded(index, !isExpanded(index));
@@ -118,7 +118,7 @@ void PanelTreeView::keyPressEvent(QKeyEvent *event)
 
     if (event->key() == Qt::Key_Return)
     {
-        if (model()->rowCount(index) == 0)
+        if (!model()->hasChildren(index))
             openUrl(qVariantValue< KUrl >(index.data(Qt::UserRole)));
         else
             setExpanded(index, !isExpanded(index));
@@ -32,6 +32,7 @@
 
 // Local Includes
 #include "application.h"
+#include "filewriter.h"
 #include "historymanager.h"
 #include "mainview.h"
 #include "mainwindow.h"
@@ -47,6 +48,9 @@
 // Only used internally
 bool readSessionDocument(QDomDocument & document, const QString & sessionFilePath)
 {
+    // the last saved session may still be on its way to disk
+    rApp->fileWriter()->flush(sessionFilePath);
+
     QFile sessionFile(sessionFilePath);
 
     if (!sessionFile.exists())
@@ -120,12 +124,6 @@ void SessionManager::saveSession()
 
     kDebug() << "SAVING SESSION...";
 
-    QFile sessionFile(m_sessionFilePath);
-    if (!sessionFile.open(QFile::WriteOnly | QFile::Truncate))
-    {
-        kDebug() << "Unable to open session file" << sessionFile.fileName();
-        return;
-    }
     MainWindowList wl = rApp->mainWindowList();
     QDomDocument document("session");
     QDomElement session = document.createElement("session");
@@ -164,9 +162,8 @@ void SessionManager::saveSession()
             session.appendChild(window);
     }
 
-    QTextStream TextStream(&sessionFile);
-    document.save(TextStream, 2);
-    sessionFile.close();
+    // written (then renamed over the old one) in a worker thread
+    rApp->fileWriter()->replaceFile(m_sessionFilePath, document.toByteArray(2));
 
     m_safe = true;
     return;
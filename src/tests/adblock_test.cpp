@@ -0,0 +1,398 @@
+/* ============================================================
+*
+* This file is a part of the rekonq project
+*
+* Copyright (C) 2012 by Andrea Diamantini <adjam7 at gmail dot com>
+*
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as
+* published by the Free Software Foundation; either version 2 of
+* the License or (at your option) version 3 or any later version
+* accepted by the membership of KDE e.V. (or its successor approved
+* by the membership of KDE e.V.), which shall act as a proxy
+* defined in Section 14 of version 3 of the license.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* ============================================================ */
+
+#include <qtest_kde.h>
+
+#include "adblockmanager.h"
+#include "adblockoptions.h"
+#include "adblockruleset.h"
+
+#include <KConfig>
+#include <KConfigGroup>
+#include <KStandardDirs>
+#include <KTempDir>
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+
+
+class AdBlockTest : public QObject
+{
+    Q_OBJECT
+
+public Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+private Q_SLOTS:
+    void hostRules_data();
+    void hostRules();
+
+    void urlRules_data();
+    void urlRules();
+
+    void ruleOptions();
+    void requestOptions();
+    void blockWithoutPage();
+
+    void hideRules();
+
+    void cacheRoundTrip();
+    void staleCache();
+    void truncatedCache();
+    void corruptedCache();
+
+private:
+    bool isBlocked(const QString &url, quint16 requestOptions) const;
+
+    void writeRules(const QStringList &rules);
+    AdBlockRuleSet *loadRules() const;
+    QString cacheFilePath() const;
+
+    KTempDir rulesDir;
+    KTempDir cacheDir;
+    QString rulesFilePath;
+
+    AdBlockRuleSet *ruleSet;
+};
+
+
+static const quint16 firstPartyImage = AdBlockOptions::ImageRequest | AdBlockOptions::FirstParty;
+
+
+// -------------------------------------------
+
+void AdBlockTest::initTestCase()
+{
+    rulesFilePath = QDir(rulesDir.name()).filePath(QL1S("rules"));
+
+    writeRules(QStringList()
+               << QL1S("[Adblock Plus 2.0]")
+               << QL1S("! host rules")
+               << QL1S("||ads.example.com^")
+               << QL1S("@@||ads.example.com/allowed^")
+               << QL1S("! url rules")
+               << QL1S("/banner/*/img^")
+               << QL1S("/ads?\\d/$script")
+               << QL1S("||tracker.net^$third-party")
+               << QL1S("! hide rules")
+               << QL1S("##.ad-banner")
+               << QL1S("##.excepted-everywhere")
+               << QL1S("#@#.excepted-everywhere")
+               << QL1S("example.org##.sponsor")
+               << QL1S("example.org#@#.ad-banner")
+               << QL1S("##a[title=\"</style><script>\"]")
+               << QL1S("example.org##div{color:red}"));
+
+    ruleSet = loadRules();
+}
+
+
+void AdBlockTest::cleanupTestCase()
+{
+    delete ruleSet;
+}
+
+
+// -------------------------------------------
+
+void AdBlockTest::hostRules_data()
+{
+    QTest::addColumn<QString>("host");
+    QTest::addColumn<bool>("result");
+
+    QTest::newRow("listed")         << "ads.example.com"            << true  ;
+    QTest::newRow("subdomain")      << "cdn.ads.example.com"        << true  ;
+    QTest::newRow("trailing dot")   << "ads.example.com."           << true  ;
+    QTest::newRow("parent")         << "example.com"                << false ;
+    QTest::newRow("same suffix")    << "badads.example.com"         << false ;
+    QTest::newRow("as a label")     << "ads.example.com.other.org"  << false ;
+}
+
+
+void AdBlockTest::hostRules()
+{
+    QFETCH(QString, host);
+    QFETCH(bool, result);
+
+    QCOMPARE(ruleSet->isHostBlackListed(host, firstPartyImage), result);
+}
+
+
+void AdBlockTest::urlRules_data()
+{
+    QTest::addColumn<QString>("url");
+    QTest::addColumn<int>("requestOptions");
+    QTest::addColumn<bool>("result");
+
+    const int firstPartyScript = AdBlockOptions::ScriptRequest | AdBlockOptions::FirstParty;
+    const int thirdPartyImage = AdBlockOptions::ImageRequest | AdBlockOptions::ThirdParty;
+
+    QTest::newRow("host")           << "http://ads.example.com/x.png"           << int(firstPartyImage)  << true  ;
+    QTest::newRow("white host")     << "http://ads.example.com/allowed/x.png"   << int(firstPartyImage)  << false ;
+    QTest::newRow("wildcard")       << "http://a.org/banner/top/img?id=1"       << int(firstPartyImage)  << true  ;
+    QTest::newRow("no wildcard")    << "http://a.org/banner/img"                << int(firstPartyImage)  << false ;
+    QTest::newRow("regexp")         << "http://a.org/ads1.js"                   << firstPartyScript      << true  ;
+    QTest::newRow("regexp type")    << "http://a.org/ads1.png"                  << int(firstPartyImage)  << false ;
+    QTest::newRow("no regexp")      << "http://a.org/adsx.js"                   << firstPartyScript      << false ;
+    QTest::newRow("third party")    << "http://tracker.net/t.gif"               << thirdPartyImage       << true  ;
+    QTest::newRow("first party")    << "http://tracker.net/t.gif"               << int(firstPartyImage)  << false ;
+}
+
+
+void AdBlockTest::urlRules()
+{
+    QFETCH(QString, url);
+    QFETCH(int, requestOptions);
+    QFETCH(bool, result);
+
+    QCOMPARE(isBlocked(url, requestOptions), result);
+}
+
+
+void AdBlockTest::ruleOptions()
+{
+    QStringList otherOptions;
+    const quint16 options = AdBlockOptions::ruleOptions(QStringList() << QL1S("script")
+                                                                      << QL1S("third-party")
+                                                                      << QL1S("domain=example.com"),
+                                                        &otherOptions);
+
+    QVERIFY(AdBlockOptions::applies(options, AdBlockOptions::ScriptRequest | AdBlockOptions::ThirdParty));
+    QVERIFY(!AdBlockOptions::applies(options, AdBlockOptions::ScriptRequest | AdBlockOptions::FirstParty));
+    QVERIFY(!AdBlockOptions::applies(options, AdBlockOptions::ImageRequest | AdBlockOptions::ThirdParty));
+    QCOMPARE(otherOptions, QStringList() << QL1S("domain=example.com"));
+
+    const quint16 notImages = AdBlockOptions::ruleOptions(QStringList() << QL1S("~image"), &otherOptions);
+    QVERIFY(AdBlockOptions::applies(notImages, AdBlockOptions::ScriptRequest | AdBlockOptions::FirstParty));
+    QVERIFY(!AdBlockOptions::applies(notImages, AdBlockOptions::ImageRequest | AdBlockOptions::FirstParty));
+
+    // documents are blocked just when asked
+    const quint16 noOptions = AdBlockOptions::ruleOptions(QStringList(), &otherOptions);
+    QVERIFY(!AdBlockOptions::applies(noOptions, AdBlockOptions::DocumentRequest | AdBlockOptions::FirstParty));
+
+    QVERIFY(!AdBlockOptions::isThirdParty(QUrl(QL1S("http://cdn.example.co.uk/a.js")), QUrl(QL1S("http://www.example.co.uk/"))));
+    QVERIFY(AdBlockOptions::isThirdParty(QUrl(QL1S("http://cdn.other.com/a.js")), QUrl(QL1S("http://www.example.com/"))));
+}
+
+
+void AdBlockTest::requestOptions()
+{
+    // no frame: the party is the referer one
+    QNetworkRequest script(QUrl(QL1S("http://cdn.other.com/lib.js")));
+    script.setRawHeader("Referer", "http://www.example.com/");
+    QCOMPARE(AdBlockOptions::requestOptions(script), quint16(AdBlockOptions::ScriptRequest | AdBlockOptions::ThirdParty));
+
+    // asking for html, whatever they are
+    QNetworkRequest xmlHttp(QUrl(QL1S("http://www.example.com/page.html")));
+    xmlHttp.setRawHeader("Accept", "text/html, */*");
+    xmlHttp.setRawHeader("X-Requested-With", "XMLHttpRequest");
+    xmlHttp.setRawHeader("Referer", "http://www.example.com/");
+    QCOMPARE(AdBlockOptions::requestOptions(xmlHttp), quint16(AdBlockOptions::XmlHttpRequest | AdBlockOptions::FirstParty));
+
+    QNetworkRequest noFrame(QUrl(QL1S("http://www.example.com/page.html")));
+    noFrame.setRawHeader("Accept", "text/html");
+    QVERIFY(!(AdBlockOptions::requestOptions(noFrame) & AdBlockOptions::DocumentRequest));
+    QVERIFY(!(AdBlockOptions::requestOptions(noFrame) & AdBlockOptions::SubDocumentRequest));
+}
+
+
+void AdBlockTest::blockWithoutPage()
+{
+    // the manager settings and local rules, where it looks for them
+    KConfig adblockConfig(KStandardDirs::locateLocal("appdata", QL1S("adblockrc")), KConfig::SimpleConfig);
+    adblockConfig.group("Settings").writeEntry("adBlockEnabled", true);
+    adblockConfig.sync();
+
+    const QString localRulesFilePath = KStandardDirs::locateLocal("appdata", QL1S("adblockrules_local"));
+    QFile::remove(localRulesFilePath);
+    QVERIFY(QFile::copy(rulesFilePath, localRulesFilePath));
+
+    AdBlockManager manager;
+    QVERIFY(manager.isEnabled());
+
+    // rules are loaded in a worker thread: requests pass, meanwhile
+    const QNetworkRequest request(QUrl(QL1S("http://ads.example.com/x.png")));
+    QNetworkReply *reply = manager.block(request, 0);
+    for (int i = 0; !reply && i < 100; ++i)
+    {
+        QTest::qWait(50);
+        reply = manager.block(request, 0);
+    }
+
+    // no page, nothing to collapse: blocked anyway
+    QVERIFY(reply);
+    delete reply;
+
+    QVERIFY(!manager.block(QNetworkRequest(QUrl(QL1S("http://www.example.com/"))), 0));
+}
+
+
+void AdBlockTest::hideRules()
+{
+    const QStringList otherRules = ruleSet->hideRules(QL1S("other.com"));
+    QVERIFY(otherRules.contains(QL1S(".ad-banner")));
+    QVERIFY(!otherRules.contains(QL1S(".excepted-everywhere")));
+
+    // the selectors closing the style element, or the css rule, are dropped
+    QCOMPARE(otherRules.count(), 1);
+    QVERIFY(!ruleSet->hideStyleSheet(QL1S("other.com")).contains(QL1C('<')));
+    QCOMPARE(ruleSet->domainHideRules(QL1S("www.example.org")), QStringList() << QL1S(".sponsor"));
+
+    // generic selectors excepted by domain
+    QVERIFY(ruleSet->hideRules(QL1S("www.example.org")).isEmpty());
+    QVERIFY(!ruleSet->hideStyleSheet(QL1S("www.example.org")).contains(QL1S(".ad-banner")));
+    QVERIFY(ruleSet->hideStyleSheet(QL1S("other.com")).contains(QL1S(".ad-banner")));
+}
+
+
+void AdBlockTest::cacheRoundTrip()
+{
+    QVERIFY(QFile::exists(cacheFilePath()));
+
+    AdBlockRuleSet *cachedRuleSet = loadRules();
+    QCOMPARE(cachedRuleSet->hostRulesCount(), ruleSet->hostRulesCount());
+    QCOMPARE(cachedRuleSet->textRulesCount(), ruleSet->textRulesCount());
+    QCOMPARE(cachedRuleSet->indexedRulesCount(AdBlockRuleTable::RegExpRule), ruleSet->indexedRulesCount(AdBlockRuleTable::RegExpRule));
+    QCOMPARE(cachedRuleSet->indexedRulesCount(AdBlockRuleTable::PatternRule), ruleSet->indexedRulesCount(AdBlockRuleTable::PatternRule));
+    QCOMPARE(cachedRuleSet->hideRulesCount(), ruleSet->hideRulesCount());
+    QCOMPARE(cachedRuleSet->hideRules(QL1S("other.com")), ruleSet->hideRules(QL1S("other.com")));
+
+    const QString url = QL1S("http://a.org/ads1.js");
+    QVERIFY(cachedRuleSet->isBlackListed(QNetworkRequest(QUrl(url)), url, url,
+                                         AdBlockOptions::ScriptRequest | AdBlockOptions::FirstParty));
+
+    delete cachedRuleSet;
+}
+
+
+void AdBlockTest::staleCache()
+{
+    QFile rulesFile(rulesFilePath);
+    QVERIFY(rulesFile.open(QFile::Append | QFile::Text));
+    rulesFile.write("||new.example.net^\n");
+    rulesFile.close();
+
+    // the cache is older than the rules now
+    AdBlockRuleSet *newRuleSet = loadRules();
+    QVERIFY(newRuleSet->isHostBlackListed(QL1S("new.example.net"), firstPartyImage));
+    QCOMPARE(newRuleSet->hostRulesCount(), ruleSet->hostRulesCount() + 1);
+    delete newRuleSet;
+
+    // and up to date again
+    newRuleSet = loadRules();
+    QVERIFY(newRuleSet->isHostBlackListed(QL1S("new.example.net"), firstPartyImage));
+    delete newRuleSet;
+}
+
+
+void AdBlockTest::truncatedCache()
+{
+    // the cache is up to date after a load
+    AdBlockRuleSet *parsedRuleSet = loadRules();
+    QVERIFY(QFile::exists(cacheFilePath()));
+
+    QFile cacheFile(cacheFilePath());
+    QVERIFY(cacheFile.resize(cacheFile.size() - 5));
+
+    // loaded from the rules file again, just once
+    AdBlockRuleSet *newRuleSet = loadRules();
+    QCOMPARE(newRuleSet->hostRulesCount(), parsedRuleSet->hostRulesCount());
+    QCOMPARE(newRuleSet->indexedRulesCount(AdBlockRuleTable::PatternRule), parsedRuleSet->indexedRulesCount(AdBlockRuleTable::PatternRule));
+    QCOMPARE(newRuleSet->hideRulesCount(), parsedRuleSet->hideRulesCount());
+    QVERIFY(newRuleSet->isHostBlackListed(QL1S("ads.example.com"), firstPartyImage));
+
+    delete newRuleSet;
+    delete parsedRuleSet;
+}
+
+
+void AdBlockTest::corruptedCache()
+{
+    AdBlockRuleSet *parsedRuleSet = loadRules();
+
+    // one record more than there are, in the header (after magic, version, rules file size and time):
+    // all the records are loaded before finding out
+    QFile cacheFile(cacheFilePath());
+    QVERIFY(cacheFile.open(QFile::ReadWrite));
+    QDataStream stream(&cacheFile);
+    QVERIFY(cacheFile.seek(20));
+    quint32 recordCount;
+    stream >> recordCount;
+    QVERIFY(cacheFile.seek(20));
+    stream << recordCount + 1;
+    cacheFile.close();
+
+    // and thrown away: no rule is loaded twice
+    AdBlockRuleSet *newRuleSet = loadRules();
+    QCOMPARE(newRuleSet->hostRulesCount(), parsedRuleSet->hostRulesCount());
+    QCOMPARE(newRuleSet->textRulesCount(), parsedRuleSet->textRulesCount());
+    QCOMPARE(newRuleSet->indexedRulesCount(AdBlockRuleTable::RegExpRule), parsedRuleSet->indexedRulesCount(AdBlockRuleTable::RegExpRule));
+    QCOMPARE(newRuleSet->indexedRulesCount(AdBlockRuleTable::PatternRule), parsedRuleSet->indexedRulesCount(AdBlockRuleTable::PatternRule));
+    QCOMPARE(newRuleSet->hideRules(QL1S("other.com")), parsedRuleSet->hideRules(QL1S("other.com")));
+    QCOMPARE(newRuleSet->hideRulesCount(), parsedRuleSet->hideRulesCount());
+
+    delete newRuleSet;
+    delete parsedRuleSet;
+}
+
+
+// -------------------------------------------
+
+bool AdBlockTest::isBlocked(const QString &url, quint16 requestOptions) const
+{
+    const QNetworkRequest request((QUrl(url)));
+    return ruleSet->decision(request, url, url.toLower(), request.url().host(), requestOptions)
+           != AdBlockRuleSet::NotBlocked;
+}
+
+
+void AdBlockTest::writeRules(const QStringList &rules)
+{
+    QFile rulesFile(rulesFilePath);
+    QVERIFY(rulesFile.open(QFile::WriteOnly | QFile::Text));
+    rulesFile.write(rules.join(QL1S("\n")).toUtf8() + '\n');
+}
+
+
+AdBlockRuleSet *AdBlockTest::loadRules() const
+{
+    return AdBlockRuleSet::loadFiles(QStringList(rulesFilePath), cacheDir.name());
+}
+
+
+QString AdBlockTest::cacheFilePath() const
+{
+    return QDir(cacheDir.name()).filePath(QL1S("rules"));
+}
+
+
+// -------------------------------------------
+
+QTEST_KDEMAIN(AdBlockTest, NoGUI)
+#include "adblock_test.moc"
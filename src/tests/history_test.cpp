@@ -0,0 +1,309 @@
+/* ============================================================
+*
+* This file is a part of the rekonq project
+*
+* Copyright (C) 2012 by Andrea Diamantini <adjam7 at gmail dot com>
+*
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as
+* published by the Free Software Foundation; either version 2 of
+* the License or (at your option) version 3 or any later version
+* accepted by the membership of KDE e.V. (or its successor approved
+* by the membership of KDE e.V.), which shall act as a proxy
+* defined in Section 14 of version 3 of the license.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* ============================================================ */
+
+#include <qtest_kde.h>
+
+#include "historyfile.h"
+#include "historymanager.h"
+
+#include <KTempDir>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+
+class HistoryTest : public QObject
+{
+    Q_OBJECT
+
+public Q_SLOTS:
+    void initTestCase();
+
+private Q_SLOTS:
+    void addItems();
+    void revisitItems();
+    void removeItems();
+    void compactItems();
+
+    void appendFile();
+    void reloadFile();
+    void truncateBrokenTail();
+    void refuseOtherFiles();
+
+private:
+    HistoryItem item(const QString &url, int minute, const QString &title = QString()) const;
+    QString filePath(const QString &name) const;
+    void appendToFile(const QString &path, const QByteArray &data);
+
+    KTempDir historyDir;
+    QDateTime startTime;
+};
+
+
+// -------------------------------------------
+
+void HistoryTest::initTestCase()
+{
+    startTime = QDateTime::fromMSecsSinceEpoch(Q_INT64_C(1340000000123));
+}
+
+
+// -------------------------------------------
+
+void HistoryTest::addItems()
+{
+    HistoryList list;
+    list.prepend(item(QL1S("http://kde.org/"), 0, QL1S("KDE")));
+    list.prepend(item(QL1S("http://kde.org/news"), 1));
+    list.prepend(item(QL1S("http://rekonq.kde.org/"), 2, QString::fromUtf8("rekonq, \xc3\xa8 veloce")));
+
+    QCOMPARE(list.count(), 3);
+    QCOMPARE(list.at(0), item(QL1S("http://rekonq.kde.org/"), 2, QString::fromUtf8("rekonq, \xc3\xa8 veloce")));
+    QCOMPARE(list.at(2), item(QL1S("http://kde.org/"), 0, QL1S("KDE")));
+    QCOMPARE(list.last(), list.at(2));
+    QCOMPARE(list.row(QL1S("http://kde.org/news")), 1);
+    QCOMPARE(list.row(QL1S("http://kde.org/other")), -1);
+    QCOMPARE(list.lastDateTimeVisitAt(1), startTime.addSecs(60));
+
+    // items have an increasing serial
+    QCOMPARE(list.itemWithSerial(list.serialAt(1)).url, QString(QL1S("http://kde.org/news")));
+    QCOMPARE(list.itemsSince(list.serialAt(2)).count(), 2);
+}
+
+
+void HistoryTest::revisitItems()
+{
+    HistoryList list;
+    list.prepend(item(QL1S("http://kde.org/"), 0));
+    list.prepend(item(QL1S("http://kde.org/news"), 1));
+    list.prepend(item(QL1S("http://rekonq.kde.org/"), 2));
+
+    const int oldSerial = list.serialAt(2);
+
+    HistoryItem visit = item(QL1S("http://kde.org/"), 3, QL1S("KDE"));
+    visit.firstDateTimeVisit = startTime;
+    visit.visitCount = 2;
+    list.prepend(visit);
+
+    // the same url just once, now the most recent
+    QCOMPARE(list.count(), 3);
+    QCOMPARE(list.at(0), visit);
+    QCOMPARE(list.at(0).visitCount, 2);
+    QCOMPARE(list.row(QL1S("http://kde.org/")), 0);
+    QCOMPARE(list.row(QL1S("http://rekonq.kde.org/")), 1);
+    QVERIFY(list.itemWithSerial(oldSerial).url.isEmpty());
+}
+
+
+void HistoryTest::removeItems()
+{
+    HistoryList list;
+    list.prepend(item(QL1S("http://kde.org/"), 0));
+    list.prepend(item(QL1S("http://kde.org/news"), 1));
+    list.prepend(item(QL1S("http://rekonq.kde.org/"), 2));
+
+    QCOMPARE(list.take(QL1S("http://kde.org/news")).url, QString(QL1S("http://kde.org/news")));
+    QVERIFY(list.take(QL1S("http://kde.org/news")).url.isEmpty());
+    QVERIFY(!list.contains(QL1S("http://kde.org/news")));
+    QCOMPARE(list.count(), 2);
+    QCOMPARE(list.row(QL1S("http://kde.org/")), 1);
+
+    QCOMPARE(list.takeLast().url, QString(QL1S("http://kde.org/")));
+    QCOMPARE(list.count(), 1);
+
+    list.clear();
+    QVERIFY(list.isEmpty());
+    QVERIFY(!list.contains(QL1S("http://rekonq.kde.org/")));
+}
+
+
+void HistoryTest::compactItems()
+{
+    // enough revisits to leave (and compact) thousands of holes
+    const int count = 1000;
+    HistoryList list;
+    for (int visit = 0; visit < 5 * count; ++visit)
+    {
+        const int i = visit % count;
+        list.prepend(item(QString(QL1S("http://site%1.org/page")).arg(i), visit, QString::number(visit)));
+    }
+
+    for (int i = 0; i < count; i += 2)
+        list.take(QString(QL1S("http://site%1.org/page")).arg(i));
+
+    QCOMPARE(list.count(), count / 2);
+    for (int row = 0; row < list.count(); ++row)
+    {
+        const int i = count - 1 - 2 * row;
+        const QString url = QString(QL1S("http://site%1.org/page")).arg(i);
+        QCOMPARE(list.at(row), item(url, 4 * count + i, QString::number(4 * count + i)));
+        QCOMPARE(list.row(url), row);
+    }
+
+    QCOMPARE(list.toList().count(), count / 2);
+    QCOMPARE(list.itemsSince(-1).first(), list.last());
+}
+
+
+// -------------------------------------------
+
+void HistoryTest::appendFile()
+{
+    const QString path = filePath(QL1S("appended"));
+
+    HistoryFile file(path);
+    QList<HistoryItem> items;
+    QVERIFY(!file.load(&items));
+
+    appendToFile(path, file.appendData(QList<HistoryItem>()
+                                       << item(QL1S("http://kde.org/"), 0, QL1S("KDE"))
+                                       << item(QL1S("http://kde.org/news"), 1),
+                                       QStringList()));
+    QCOMPARE(file.recordCount(), 2);
+
+    // nothing to add: no data at all
+    QVERIFY(file.appendData(QList<HistoryItem>(), QStringList()).isEmpty());
+
+    HistoryFile loadedFile(path);
+    QVERIFY(loadedFile.load(&items));
+    QCOMPARE(items, QList<HistoryItem>()
+             << item(QL1S("http://kde.org/"), 0, QL1S("KDE"))
+             << item(QL1S("http://kde.org/news"), 1));
+    QCOMPARE(loadedFile.recordCount(), 2);
+}
+
+
+void HistoryTest::reloadFile()
+{
+    const QString path = filePath(QL1S("reloaded"));
+
+    HistoryFile file(path);
+    appendToFile(path, file.appendData(QList<HistoryItem>()
+                                       << item(QL1S("http://kde.org/"), 0, QL1S("KDE"))
+                                       << item(QL1S("http://kde.org/news"), 1)
+                                       << item(QL1S("http://rekonq.kde.org/"), 2),
+                                       QStringList()));
+
+    // a revisit, a removal and a new item, in a second save
+    HistoryItem visit = item(QL1S("http://kde.org/"), 3, QString::fromUtf8("KDE \xe2\x80\x94 home"));
+    visit.firstDateTimeVisit = startTime;
+    visit.visitCount = 2;
+    appendToFile(path, file.appendData(QList<HistoryItem>()
+                                       << visit
+                                       << item(QL1S("http://kde.org/apps"), 4),
+                                       QStringList() << QL1S("http://kde.org/news")));
+
+    QList<HistoryItem> items;
+    HistoryFile loadedFile(path);
+    QVERIFY(loadedFile.load(&items));
+
+    // oldest first, the last record of an url winning
+    QCOMPARE(items, QList<HistoryItem>()
+             << item(QL1S("http://rekonq.kde.org/"), 2)
+             << visit
+             << item(QL1S("http://kde.org/apps"), 4));
+    QCOMPARE(items.at(1).visitCount, 2);
+    QCOMPARE(loadedFile.recordCount(), 6);
+
+    // rewritten: just the live records
+    QFile::remove(path);
+    appendToFile(path, loadedFile.rewriteData(items));
+    QCOMPARE(loadedFile.recordCount(), 3);
+
+    QList<HistoryItem> rewrittenItems;
+    QVERIFY(HistoryFile(path).load(&rewrittenItems));
+    QCOMPARE(rewrittenItems, items);
+}
+
+
+void HistoryTest::truncateBrokenTail()
+{
+    const QString path = filePath(QL1S("broken"));
+
+    HistoryFile file(path);
+    appendToFile(path, file.appendData(QList<HistoryItem>() << item(QL1S("http://kde.org/"), 0), QStringList()));
+    const qint64 goodSize = QFileInfo(path).size();
+
+    // a save interrupted midway
+    QByteArray data = file.appendData(QList<HistoryItem>() << item(QL1S("http://kde.org/news"), 1), QStringList());
+    data.chop(3);
+    appendToFile(path, data);
+
+    QList<HistoryItem> items;
+    HistoryFile loadedFile(path);
+    QVERIFY(loadedFile.load(&items));
+    QCOMPARE(items, QList<HistoryItem>() << item(QL1S("http://kde.org/"), 0));
+    QCOMPARE(loadedFile.recordCount(), 1);
+    QCOMPARE(QFileInfo(path).size(), goodSize);
+
+    // and appended to after the good part
+    appendToFile(path, loadedFile.appendData(QList<HistoryItem>() << item(QL1S("http://kde.org/apps"), 2), QStringList()));
+
+    items.clear();
+    QVERIFY(HistoryFile(path).load(&items));
+    QCOMPARE(items, QList<HistoryItem>()
+             << item(QL1S("http://kde.org/"), 0)
+             << item(QL1S("http://kde.org/apps"), 2));
+}
+
+
+void HistoryTest::refuseOtherFiles()
+{
+    const QString path = filePath(QL1S("other"));
+    appendToFile(path, QByteArray("not an history file"));
+
+    QList<HistoryItem> items;
+    QVERIFY(!HistoryFile(path).load(&items));
+    QVERIFY(items.isEmpty());
+}
+
+
+// -------------------------------------------
+
+HistoryItem HistoryTest::item(const QString &url, int minute, const QString &title) const
+{
+    return HistoryItem(url, startTime.addSecs(60 * minute), title);
+}
+
+
+QString HistoryTest::filePath(const QString &name) const
+{
+    return QDir(historyDir.name()).filePath(name);
+}
+
+
+void HistoryTest::appendToFile(const QString &path, const QByteArray &data)
+{
+    QFile file(path);
+    QVERIFY(file.open(QFile::WriteOnly | QFile::Append));
+    QCOMPARE(file.write(data), qint64(data.size()));
+}
+
+
+// -------------------------------------------
+
+QTEST_KDEMAIN(HistoryTest, NoGUI)
+#include "history_test.moc"
@@ -310,7 +310,7 @@ bool CompletionWidget::eventFilter(QObject *obj, QEvent *ev)
                 }
                 else //the user type too fast (completionwidget not visible or suggestion not downloaded)
                 {
-                    UrlResolver res(w->text());
+                    UrlResolver res(w->text(), &_resolverSession);
                     UrlSearchList list = res.orderedSearchItems();
                     if (list.isEmpty())
                     {
@@ -390,9 +390,12 @@ void CompletionWidget::suggestUrls(const QString &text)
     if (!isVisible())
     {
         UrlResolver::setSearchEngine(SearchEngine::defaultEngine());
+
+        // typing again: nothing to refine
+        _resolverSession = UrlResolverSession();
     }
 
-    UrlResolver *res = new UrlResolver(text);
+    UrlResolver *res = new UrlResolver(text, &_resolverSession);
     connect(res, SIGNAL(suggestionsReady(UrlSearchList, QString)),
             this, SLOT(updateSearchList(UrlSearchList, QString)));
     _resList = res->orderedSearchItems();
@@ -88,6 +88,9 @@ private:
     bool _hasSuggestions;
 
     UrlSearchList _resList;
+
+    // what was found for the text typed so far, while the popup is shown
+    UrlResolverSession _resolverSession;
 };
 
 #endif // COMPLETION_WIDGET_H
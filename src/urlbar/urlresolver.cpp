@@ -51,6 +51,12 @@
 // 5. "fixhosturifilter"
 
 
+// NOTE
+// The const int here decides the number of proper suggestions, taken from history & bookmarks
+// You have to add here the "browse & search" options, always available.
+static const int availableEntries = 8;
+
+
 // ------------------------------------------------------------------------
 
 KService::Ptr UrlResolver::_searchEngine;
@@ -59,11 +65,12 @@ QRegExp UrlResolver::_browseRegexp;
 QRegExp UrlResolver::_searchEnginesRegexp;
 
 
-UrlResolver::UrlResolver(const QString &typedUrl)
+UrlResolver::UrlResolver(const QString &typedUrl, UrlResolverSession *session)
     : QObject()
     , _typedString(typedUrl.trimmed())
     , _typedQuery()
     , _isKDEUrl(false)
+    , _session(session)
 {
     if (!_searchEngine)
         setSearchEngine(SearchEngine::defaultEngine());
@@ -167,11 +174,6 @@ UrlSearchList UrlResolver::orderedSearchItems()
 
 UrlSearchList UrlResolver::orderLists()
 {
-    // NOTE
-    // The const int here decides the number of proper suggestions, taken from history & bookmarks
-    // You have to add here the "browse & search" options, always available.
-    const int availableEntries = 8;
-
     bool webSearchFirst = false;
     // Browse & Search results
     UrlSearchList browseSearch;
@@ -309,16 +311,28 @@ void UrlResolver::computeWebSearches()
 // history
 void UrlResolver::computeHistory()
 {
-    QList<HistoryItem> found = rApp->historyManager()->find(_typedString);
-    qSort(found.begin(), found.end(), isHistoryItemRelevant);
-
-    Q_FOREACH(const HistoryItem & i, found)
+    // just the most relevant items: orderLists() does not show more than availableEntries.
+    // Ask for more, when search engine results filtered too many of them out
+    int count = availableEntries;
+    Q_FOREVER
     {
-        if (_searchEnginesRegexp.isEmpty() || _searchEnginesRegexp.indexIn(i.url) == -1) //filter all urls that are search engine results
+        const QList<HistoryItem> found = rApp->historyManager()->findRelevant(_typedString, count,
+                                         _session ? &_session->history : 0);
+
+        _history.clear();
+        Q_FOREACH(const HistoryItem & i, found)
         {
-            UrlSearchItem gItem(UrlSearchItem::History, i.url, i.title);
-            _history << gItem;
+            if (_searchEnginesRegexp.isEmpty() || _searchEnginesRegexp.indexIn(i.url) == -1) //filter all urls that are search engine results
+            {
+                UrlSearchItem gItem(UrlSearchItem::History, i.url, i.title);
+                _history << gItem;
+            }
         }
+
+        if (_history.count() >= availableEntries || found.count() < count)
+            return;
+
+        count *= 4;
     }
 }
 
@@ -326,7 +340,20 @@ void UrlResolver::computeHistory()
 // bookmarks
 void UrlResolver::computeBookmarks()
 {
-    QList<KBookmark> found = rApp->bookmarkManager()->find(_typedString);
+    // the text grew: the bookmarks found before are the only ones that can match
+    QList<KBookmark> found;
+    if (_session && _session->hasBookmarks && _typedString.startsWith(_session->bookmarksText))
+        found = rApp->bookmarkManager()->find(_typedString, _session->bookmarks);
+    else
+        found = rApp->bookmarkManager()->find(_typedString);
+
+    if (_session)
+    {
+        _session->bookmarksText = _typedString;
+        _session->bookmarks = found;
+        _session->hasBookmarks = true;
+    }
+
     Q_FOREACH(const KBookmark & b, found)
     {
         UrlSearchItem gItem(UrlSearchItem::Bookmark, b.url().url(), b.fullText());
@@ -342,6 +369,7 @@ void UrlResolver::computeSuggestions()
     // This attempt basically cuts out open search suggestions.
     UrlSearchList list;
     emit suggestionsReady(list, _typedString);
+    this->deleteLater();
     return;
 
 //     // if a string startsWith /, it is probably a local path
@@ -371,12 +399,6 @@ void UrlResolver::computeSuggestions()
 }
 
 
-bool UrlResolver::isHistoryItemRelevant(const HistoryItem &a, const HistoryItem &b)
-{
-    return a.relevance() > b.relevance();
-}
-
-
 void UrlResolver::suggestionsReceived(const QString &text, const ResponseList &suggestions)
 {
     if (text != _typedQuery)
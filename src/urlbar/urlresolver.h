@@ -33,10 +33,12 @@
 
 // Locale Includes
 #include "application.h"
+#include "historymanager.h"
 #include "opensearchmanager.h"
 #include "suggestionparser.h"
 
 // KDE Includes
+#include <KBookmark>
 #include <KUrl>
 #include <KService>
 
@@ -116,14 +118,37 @@ typedef QList <UrlSearchItem> UrlSearchList;
 
 // ----------------------------------------------------------------------
 
-class HistoryItem;
+
+/**
+ * What the UrlResolvers of a typing session found.
+ * While the typed text grows, the next resolver just refines the history
+ * and bookmarks candidates, instead of looking for them everywhere again.
+ *
+ */
+class UrlResolverSession
+{
+public:
+    UrlResolverSession()
+        : hasBookmarks(false)
+    {};
+
+    HistorySearch history;
+
+    QString bookmarksText;
+    QList<KBookmark> bookmarks;
+    bool hasBookmarks;
+};
+
+
+// ----------------------------------------------------------------------
+
 
 class UrlResolver : public QObject
 {
     Q_OBJECT
 
 public:
-    UrlResolver(const QString &typedUrl);
+    UrlResolver(const QString &typedUrl, UrlResolverSession *session = 0);
 
     UrlSearchList orderedSearchItems();
 
@@ -141,8 +166,6 @@ public:
 
     void computeSuggestions();
 
-    static bool isHistoryItemRelevant(const HistoryItem &a, const HistoryItem &b);
-
 private Q_SLOTS:
     void suggestionsReceived(const QString &text, const ResponseList &suggestions);
 
@@ -172,6 +195,8 @@ private:
     static KService::Ptr _searchEngine;
 
     bool _isKDEUrl;
+
+    UrlResolverSession *_session;
 };
 
 // ------------------------------------------------------------------------------
@@ -48,6 +48,10 @@ bool UrlFilterProxyModel::recursiveMatch(const QModelIndex &index) const
     if (index.data().toString().contains(filterRegExp()))
         return true;
 
+    // children of a lazy model are there once fetched
+    if (sourceModel()->canFetchMore(index))
+        sourceModel()->fetchMore(index);
+
     int numChildren = sourceModel()->rowCount(index);
     for (int childRow = 0; childRow < numChildren; ++childRow)
     {
@@ -74,6 +74,31 @@
 #include <QTextDocument>
 #include <QFileInfo>
 #include <QNetworkReply>
+#include <QWebElement>
+#include <QWebFrame>
+
+
+// Collapse frame elements whose (resolved) src is in urls
+static void collapseElements(QWebFrame *frame, const QSet<QString> &urls)
+{
+    Q_FOREACH(QWebFrame * childFrame, frame->childFrames())
+    {
+        collapseElements(childFrame, urls);
+    }
+
+    const QUrl baseUrl = frame->baseUrl();
+    QWebElementCollection elements = frame->findAllElements(QL1S("[src]"));
+    Q_FOREACH(QWebElement el, elements)
+    {
+        const QString src = baseUrl.resolved(QUrl(el.attribute(QL1S("src")))).toString();
+        if (!urls.contains(src))
+            continue;
+
+        el.setStyleProperty(QL1S("visibility"), QL1S("hidden"));
+        el.setStyleProperty(QL1S("width"), QL1S("0"));
+        el.setStyleProperty(QL1S("height"), QL1S("0"));
+    }
+}
 
 
 // Returns true if the scheme and domain of the two urls match...
@@ -164,6 +189,11 @@ WebPage::WebPage(QWidget *parent)
     connect(&_protHandler, SIGNAL(downloadUrl(KUrl)), this, SLOT(downloadUrl(KUrl)));
 
     connect(rApp->iconManager(), SIGNAL(iconChanged()), mainFrame(), SIGNAL(iconChanged()));
+
+    // blocked elements are collapsed in batches
+    _collapseTimer.setSingleShot(true);
+    _collapseTimer.setInterval(500);
+    connect(&_collapseTimer, SIGNAL(timeout()), this, SLOT(collapseBlockedElements()));
 }
 
 
@@ -463,6 +493,10 @@ void WebPage::loadStarted()
     _hasAdBlockedElements = false;
     rApp->adblockManager()->clearElementsLists();
 
+    _blockedUrls.clear();
+    _collapseTimer.stop();
+    _adBlockStatistics = AdBlockPageStatistics();
+
     // set zoom factor
     QString val;
     KSharedConfig::Ptr config = KGlobal::config();
@@ -485,6 +519,9 @@ void WebPage::loadFinished(bool ok)
     // Apply adblock manager hiding rules
     rApp->adblockManager()->applyHidingRules(this);
 
+    // and collapse the elements blocked till now
+    collapseBlockedElements();
+
     // KWallet Integration
     QStringList list = ReKonfig::walletBlackList();
     if (wallet()
@@ -496,6 +533,28 @@ void WebPage::loadFinished(bool ok)
 }
 
 
+void WebPage::collapseBlockedElements(const QUrl &url)
+{
+    _blockedUrls.insert(url.toString());
+
+    // do not restart it: during long loads, elements have to be collapsed anyway
+    if (!_collapseTimer.isActive())
+        _collapseTimer.start();
+}
+
+
+void WebPage::collapseBlockedElements()
+{
+    _collapseTimer.stop();
+
+    if (_blockedUrls.isEmpty())
+        return;
+
+    // NOTE: urls are kept, as their elements can be (re)added by scripts later
+    collapseElements(mainFrame(), _blockedUrls);
+}
+
+
 void WebPage::manageNetworkErrors(QNetworkReply *reply)
 {
     Q_ASSERT(reply);
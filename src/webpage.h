@@ -37,12 +37,17 @@
 #include "rekonq_defines.h"
 
 // Local Includes
+#include "adblockstatistics.h"
 #include "protocolhandler.h"
 #include "websslinfo.h"
 
 // KDE Includes
 #include <KWebPage>
 
+// Qt Includes
+#include <QSet>
+#include <QTimer>
+
 
 class REKONQ_TESTS_EXPORT WebPage : public KWebPage
 {
@@ -72,6 +77,15 @@ public:
         _hasAdBlockedElements = b;
     };
 
+    // collapse the elements loading url, at load end (or in a while)
+    void collapseBlockedElements(const QUrl &url);
+
+    // adblock work for this page, updated by AdBlockManager
+    inline AdBlockPageStatistics &adBlockStatistics()
+    {
+        return _adBlockStatistics;
+    };
+
     bool hasSslValid() const;
 
 public Q_SLOTS:
@@ -93,6 +107,7 @@ private Q_SLOTS:
     void loadStarted();
     void loadFinished(bool);
     void showSSLInfo(QPoint);
+    void collapseBlockedElements();
 
     void copyToTempFileResult(KJob*);
 
@@ -109,6 +124,13 @@ private:
     bool _networkAnalyzer;
     bool _isOnRekonqPage;
     bool _hasAdBlockedElements;
+
+    // every url blocked since the page load started (see loadStarted, clearing it).
+    // They are kept after collapsing their elements, as scripts can add them again
+    QSet<QString> _blockedUrls;
+    QTimer _collapseTimer;
+
+    AdBlockPageStatistics _adBlockStatistics;
 };
 
 #endif